@@ -0,0 +1,581 @@
+/** @file
+ * Implementacja klasy przechowującej obszary graczy w postaci lasu numerów obszarów
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 24.05.2020
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "area.h"
+#include "bfs.h"
+#include "journal.h"
+#include "player.h"
+
+/** @brief Zapewnia miejsce na obszar o podanym numerze w tablicach gracza
+ * Powiększa dwukrotnie tablice area_parent, area_size i area_refs.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] area_number   – numer obszaru,
+ */
+
+static void reserve_area_number(gamma_t *g, uint32_t player, uint32_t area_number)
+{
+    player_t *info = &g->player_info[player];
+    if (area_number < info->area_capacity)
+        return;
+
+    uint64_t capacity = info->area_capacity == 0 ? 4 : 2 * info->area_capacity;
+    if (capacity > (uint64_t) UINT32_MAX + 1)
+        capacity = (uint64_t) UINT32_MAX + 1;
+
+    info->area_parent = realloc(info->area_parent, capacity * sizeof *(info->area_parent));
+    checkNull(info->area_parent);
+    info->area_size = realloc(info->area_size, capacity * sizeof *(info->area_size));
+    checkNull(info->area_size);
+    info->area_refs = realloc(info->area_refs, capacity * sizeof *(info->area_refs));
+    checkNull(info->area_refs);
+    for (uint64_t i = info->area_capacity; i < capacity; i++)
+    {
+        info->area_parent[i] = 0;
+        info->area_size[i] = 0;
+        info->area_refs[i] = 0;
+    }
+    info->area_capacity = capacity;
+}
+
+/** @brief Znajduje wolny numer nowego obszaru
+ * Bierze pierwszy numer z listy zwolnionych numerów, a gdy jest ona pusta,
+ * przydziela kolejny nieużywany jeszcze numer.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @return Zwraca znaleziony numer.
+ */
+
+static uint32_t next_free_area_number(gamma_t *g, uint32_t player)
+{
+    player_t *info = &g->player_info[player];
+    uint32_t area_number = info->free_area_number;
+    if (area_number != 0)
+    {
+        journal_save(g, &info->free_area_number, sizeof info->free_area_number);
+        info->free_area_number = info->area_parent[area_number];
+        return area_number;
+    }
+
+    // Kolejny numer nie zmieściłby się w polu planszy.
+    if (info->used_area_numbers == UINT32_MAX)
+        exit(1);
+    journal_save(g, &info->used_area_numbers, sizeof info->used_area_numbers);
+    area_number = ++(info->used_area_numbers);
+    reserve_area_number(g, player, area_number);
+    return area_number;
+}
+
+/** @brief Zwalnia numer obszaru gracza
+ * Dopisuje numer na początek listy zwolnionych numerów.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] area_number   – zwalniany numer obszaru,
+ */
+
+static void reset_area_info(gamma_t *g, uint32_t player, uint32_t area_number)
+{
+    player_t *info = &g->player_info[player];
+    journal_save_element(g, JOURNAL_AREA_SIZE, player, area_number);
+    journal_save_element(g, JOURNAL_AREA_PARENT, player, area_number);
+    journal_save(g, &info->free_area_number, sizeof info->free_area_number);
+    info->area_size[area_number] = 0;
+    info->area_parent[area_number] = info->free_area_number;
+    info->free_area_number = area_number;
+}
+
+/** @brief Odejmuje jedno odwołanie do numeru obszaru
+ * Numer, do którego nie odwołuje się już żadne pole ani inny numer, zostaje
+ * zwolniony, a wtedy traci się też jego odwołanie do rodzica.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] area_number   – numer obszaru,
+ */
+
+static void release_area_number(gamma_t *g, uint32_t player, uint32_t area_number)
+{
+    player_t *info = &g->player_info[player];
+    while (true)
+    {
+        journal_save_element(g, JOURNAL_AREA_REFS, player, area_number);
+        if (--(info->area_refs[area_number]) != 0)
+            return;
+
+        uint32_t parent = info->area_parent[area_number];
+        reset_area_info(g, player, area_number);
+        if (parent == area_number)
+            return;
+        area_number = parent;
+    }
+}
+
+/** @brief Zwraca pamięć punktów artykulacji gracza
+ * Tablica pamięci wszystkich graczy jest alokowana przy pierwszym użyciu.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @return Wskaźnik na pamięć punktów artykulacji gracza.
+ */
+
+static cut_cache_t *cut_cache(gamma_t *g, uint32_t player)
+{
+    if (g->cut_caches == NULL)
+    {
+        g->cut_caches = calloc((uint64_t) g->players + 1, sizeof *(g->cut_caches));
+        checkNull(g->cut_caches);
+    }
+    return &g->cut_caches[player];
+}
+
+/** @brief Sprawdza czy zapamiętane liczby części pól obszaru są aktualne
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] area_number   – numer korzenia obszaru,
+ * @return Zwraca true jeśli wartości są aktualne, false w przeciwnym wypadku.
+ */
+
+static bool cuts_valid(const gamma_t *g, uint32_t player, uint32_t area_number)
+{
+    if (g->cut_caches == NULL)
+        return false;
+    const cut_cache_t *cache = &g->cut_caches[player];
+    return area_number < cache->valid_capacity && cache->valid[area_number];
+}
+
+/** @brief Oznacza zapamiętane liczby części pól obszaru jako aktualne lub nie
+ * Tablica valid jest powiększana do rozmiaru tablic obszarów gracza dopiero
+ * przy oznaczaniu obszaru jako aktualnego, bo brakujące elementy oznaczają
+ * obszary nieaktualne. Zmiana jest zapisywana w dzienniku.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] area_number   – numer korzenia obszaru,
+ * @param[in] valid   – nowa wartość flagi,
+ */
+
+static void set_cuts_valid(gamma_t *g, uint32_t player, uint32_t area_number, bool valid)
+{
+    if (cuts_valid(g, player, area_number) == valid)
+        return;
+
+    cut_cache_t *cache = cut_cache(g, player);
+    if (area_number >= cache->valid_capacity)
+    {
+        uint64_t capacity = g->player_info[player].area_capacity;
+        cache->valid = realloc(cache->valid, capacity * sizeof *(cache->valid));
+        checkNull(cache->valid);
+        for (uint64_t i = cache->valid_capacity; i < capacity; i++)
+            cache->valid[i] = false;
+        cache->valid_capacity = capacity;
+    }
+    journal_save_element(g, JOURNAL_CUT_VALID, player, area_number);
+    cache->valid[area_number] = valid;
+}
+
+/** @brief Podaje zapamiętaną liczbę części, na które rozpadnie się obszar po zabraniu pola
+ * Wynik jest poprawny tylko dla pola obszaru o aktualnych wartościach.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks zajętego pola,
+ * @param[in] size   – rozmiar obszaru pola,
+ * @return Zwraca liczbę spójnych części.
+ */
+
+static uint32_t cut_pieces(const gamma_t *g, uint64_t index, uint64_t size)
+{
+    return size == 1 ? 0 : *pieces_at(g, index);
+}
+
+void area_set_pieces(gamma_t *g, uint64_t index, uint32_t pieces)
+{
+    uint8_t *old = pieces_at(g, index);
+    if (*old == pieces)
+        return;
+    journal_save_element(g, JOURNAL_PIECES, 0, index);
+    *old = pieces;
+}
+
+/** @brief Zajmuje wolny numer obszaru gracza
+ * Nowy numer jest korzeniem i nie odwołuje się do niego jeszcze żadne pole.
+ * Liczby części pól są od razu aktualne tylko dla obszaru z jednego pola
+ * gracza, którego obszary były już sprawdzane.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] size   – rozmiar nowego obszaru,
+ * @return Zwraca zajęty numer obszaru.
+ */
+
+static uint32_t new_area_number(gamma_t *g, uint32_t player, uint64_t size)
+{
+    player_t *info = &g->player_info[player];
+    uint32_t area_number = next_free_area_number(g, player);
+    journal_save_element(g, JOURNAL_AREA_PARENT, player, area_number);
+    journal_save_element(g, JOURNAL_AREA_SIZE, player, area_number);
+    journal_save_element(g, JOURNAL_AREA_REFS, player, area_number);
+    journal_save(g, &info->current_areas, sizeof info->current_areas);
+    info->area_parent[area_number] = area_number;
+    info->area_size[area_number] = size;
+    info->area_refs[area_number] = 0;
+    (info->current_areas)++;
+    set_cuts_valid(g, player, area_number,
+                   size == 1 && g->cut_caches != NULL && g->cut_caches[player].valid != NULL);
+    return area_number;
+}
+
+uint32_t area_root(const gamma_t *g, uint32_t player, uint32_t area_number)
+{
+    const uint32_t *parent = g->player_info[player].area_parent;
+    while (parent[area_number] != area_number)
+        area_number = parent[area_number];
+    return area_number;
+}
+
+/** @brief Znajduje korzeń obszaru i skraca ścieżkę do niego
+ * Ścieżka jest skracana tylko przy wyłączonym dzienniku, bo z nim każda
+ * zmiana rodzica musiałaby zostać zapisana. Numery pominięte przez
+ * skróconą ścieżkę, do których nic się już nie odwołuje, są zwalniane.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] area_number   – numer obszaru zapisany w polu gracza,
+ * @return Zwraca numer korzenia obszaru.
+ */
+
+static uint32_t find_area(gamma_t *g, uint32_t player, uint32_t area_number)
+{
+    uint32_t root = area_root(g, player, area_number);
+    if (g->journal.enabled)
+        return root;
+
+    player_t *info = &g->player_info[player];
+    while (info->area_parent[area_number] != root)
+    {
+        uint32_t next = info->area_parent[area_number];
+        if (info->area_refs[area_number] == 0)
+            reset_area_info(g, player, area_number);
+        else
+        {
+            info->area_parent[area_number] = root;
+            (info->area_refs[root])++;
+        }
+        (info->area_refs[next])--;
+        area_number = next;
+    }
+    if (area_number != root && info->area_refs[area_number] == 0)
+    {
+        reset_area_info(g, player, area_number);
+        (info->area_refs[root])--;
+    }
+    return root;
+}
+
+/** @brief Zapisuje w polu gracza numer obszaru
+ * Dotychczasowy numer pola nie jest zmieniany w tablicach gracza.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] index   – indeks pola,
+ * @param[in] area_number   – nowy numer obszaru pola,
+ */
+
+static void set_area_number(gamma_t *g, uint32_t player, uint64_t index, uint32_t area_number)
+{
+    journal_save_element(g, JOURNAL_AREA_LABEL, 0, index);
+    *area_slot(g, index) = area_number;
+    journal_save_element(g, JOURNAL_AREA_REFS, player, area_number);
+    (g->player_info[player].area_refs[area_number])++;
+}
+
+void area_relabel_field(gamma_t *g, uint32_t player, uint64_t index, uint32_t area_number)
+{
+    release_area_number(g, player, area_at(g, index));
+    set_area_number(g, player, index, area_number);
+}
+
+/** @brief Dopisuje obszar sąsiada do tablicy, jeśli jeszcze go w niej nie ma
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] x   – współrzędna x sąsiada,
+ * @param[in] y   – współrzędna y sąsiada,
+ * @param[in, out] areas   – numery korzeni różnych obszarów,
+ * @param[in, out] touches   – liczba sąsiadów z każdego obszaru,
+ * @param[in, out] fields   – indeks ostatniego sąsiada z każdego obszaru,
+ * @param[in, out] count   – liczba obszarów w tablicy,
+ */
+
+static void add_neighbour_area(gamma_t *g, uint32_t player, uint32_t x, uint32_t y,
+                               uint32_t *areas, uint32_t *touches, uint64_t *fields, uint32_t *count)
+{
+    if (get_owner(g, x, y) != player)
+        return;
+
+    uint32_t area = find_area(g, player, area_at(g, field_index(g, x, y)));
+    uint32_t i = 0;
+    while (i < *count && areas[i] != area)
+        i++;
+    if (i == *count)
+    {
+        areas[(*count)++] = area;
+        touches[i] = 0;
+    }
+    (touches[i])++;
+    fields[i] = field_index(g, x, y);
+}
+
+/** @brief Wyznacza różne obszary gracza sąsiadujące z polem
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @param[out] areas   – tablica na co najwyżej cztery numery korzeni obszarów,
+ * @param[out] touches   – tablica na liczby sąsiadów pola z każdego obszaru,
+ * @param[out] fields   – tablica na indeksy sąsiadów pola z każdego obszaru,
+ * @return Zwraca liczbę znalezionych obszarów.
+ */
+
+static uint32_t neighbour_areas(gamma_t *g, uint32_t player, uint32_t x, uint32_t y,
+                                uint32_t *areas, uint32_t *touches, uint64_t *fields)
+{
+    uint32_t count = 0;
+    if (x > 0)
+        add_neighbour_area(g, player, x - 1, y, areas, touches, fields, &count);
+    if (x < g->max_width - 1)
+        add_neighbour_area(g, player, x + 1, y, areas, touches, fields, &count);
+    if (y > 0)
+        add_neighbour_area(g, player, x, y - 1, areas, touches, fields, &count);
+    if (y < g->max_height - 1)
+        add_neighbour_area(g, player, x, y + 1, areas, touches, fields, &count);
+    return count;
+}
+
+/** @brief Poprawia zapamiętane liczby części po dołączeniu pola do obszarów
+ * Jeśli pole styka się z każdym z sąsiednich obszarów tylko jednym bokiem,
+ * to pola tych obszarów inne niż sąsiad rozpadają się na tyle samo części
+ * co wcześniej, sąsiad odcina dodatkowo dołączane pole wraz z resztą nowego
+ * obszaru, a samo pole rozdziela wszystkie połączone obszary. W pozostałych
+ * przypadkach zmieniają się punkty artykulacji wewnątrz obszaru.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] index   – indeks dołączanego pola,
+ * @param[in] areas   – numery korzeni sąsiednich obszarów przed połączeniem,
+ * @param[in] touches   – liczba sąsiadów pola z każdego obszaru,
+ * @param[in] fields   – indeks sąsiada pola z każdego obszaru,
+ * @param[in] count   – liczba sąsiednich obszarów,
+ * @return Zwraca true jeśli wartości zostały poprawione, false jeśli trzeba je policzyć od nowa.
+ */
+
+static bool update_cuts_on_add(gamma_t *g, uint32_t player, uint64_t index, const uint32_t *areas,
+                               const uint32_t *touches, const uint64_t *fields, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        if (touches[i] != 1 || !cuts_valid(g, player, areas[i]))
+            return false;
+
+    const uint64_t *size = g->player_info[player].area_size;
+    for (uint32_t i = 0; i < count; i++)
+        area_set_pieces(g, fields[i], cut_pieces(g, fields[i], size[areas[i]]) + 1);
+    area_set_pieces(g, index, count);
+    return true;
+}
+
+void area_add_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+{
+    own_player_tables(g, player);
+    uint64_t index = field_index(g, x, y);
+    player_t *info = &g->player_info[player];
+    uint32_t areas[4];
+    uint32_t touches[4];
+    uint64_t fields[4];
+    uint32_t count = neighbour_areas(g, player, x, y, areas, touches, fields);
+
+    if (count == 0)
+    {
+        set_area_number(g, player, index, new_area_number(g, player, 1));
+        return;
+    }
+
+    bool updated = update_cuts_on_add(g, player, index, areas, touches, fields, count);
+    uint32_t main_area = areas[0];
+    for (uint32_t i = 1; i < count; i++)
+        if (info->area_size[areas[i]] > info->area_size[main_area])
+            main_area = areas[i];
+
+    // Korzenie mniejszych obszarów zostają podpięte pod korzeń największego,
+    // więc łączenie nie zmienia numerów w polach.
+    journal_save_element(g, JOURNAL_AREA_SIZE, player, main_area);
+    journal_save_element(g, JOURNAL_AREA_REFS, player, main_area);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (areas[i] == main_area)
+            continue;
+        journal_save_element(g, JOURNAL_AREA_PARENT, player, areas[i]);
+        journal_save_element(g, JOURNAL_AREA_SIZE, player, areas[i]);
+        info->area_parent[areas[i]] = main_area;
+        info->area_size[main_area] += info->area_size[areas[i]];
+        info->area_size[areas[i]] = 0;
+        (info->area_refs[main_area])++;
+    }
+
+    set_area_number(g, player, index, main_area);
+    info->area_size[main_area]++;
+    journal_save(g, &info->current_areas, sizeof info->current_areas);
+    info->current_areas -= count - 1;
+    set_cuts_valid(g, player, main_area, updated);
+}
+
+uint32_t area_split_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, area_split_t *split)
+{
+    split->count = 0;
+    if (x > 0 && get_owner(g, x - 1, y) == player)
+        split->starts[split->count++] = field_index(g, x - 1, y);
+    if (x < g->max_width - 1 && get_owner(g, x + 1, y) == player)
+        split->starts[split->count++] = field_index(g, x + 1, y);
+    if (y > 0 && get_owner(g, x, y - 1) == player)
+        split->starts[split->count++] = field_index(g, x, y - 1);
+    if (y < g->max_height - 1 && get_owner(g, x, y + 1) == player)
+        split->starts[split->count++] = field_index(g, x, y + 1);
+
+    for (uint32_t i = 0; i < 4; i++)
+        split->sizes[i] = 0;
+    if (split->count <= 1)
+        return split->count;
+
+    // Przejście kończy się z jedną niezakończoną grupą, której część nie ma rozmiaru.
+    split_area(g, player, field_index(g, x, y), split->starts, split->count, split->sizes);
+    uint32_t pieces = 1;
+    for (uint32_t i = 0; i < split->count; i++)
+        pieces += split->sizes[i] != 0;
+    return pieces;
+}
+
+void area_remove_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, const area_split_t *split)
+{
+    own_player_tables(g, player);
+    player_t *info = &g->player_info[player];
+    uint32_t old_number = area_at(g, field_index(g, x, y));
+    uint32_t old_area = find_area(g, player, old_number);
+
+    area_split_t found;
+    if (split == NULL)
+    {
+        area_split_field(g, player, x, y, &found);
+        split = &found;
+    }
+
+    // Obszar złożony z jednego pola traci wraz z nim ostatnie odwołanie
+    // i jego numer zostaje zwolniony.
+    release_area_number(g, player, old_number);
+    if (split->count == 0)
+    {
+        journal_save(g, &info->current_areas, sizeof info->current_areas);
+        (info->current_areas)--;
+        return;
+    }
+
+    // Część, której przejście nie zostało zakończone, zachowuje dotychczasowy
+    // korzeń, a nowe numery dostają tylko pola mniejszych części.
+    journal_save_element(g, JOURNAL_AREA_SIZE, player, old_area);
+    (info->area_size[old_area])--;
+    for (uint32_t i = 0; i < split->count; i++)
+    {
+        if (split->sizes[i] == 0)
+            continue;
+        uint32_t area_number = new_area_number(g, player, split->sizes[i]);
+        relabel_area(g, split->starts[i], player, old_area, area_number);
+        info->area_size[old_area] -= split->sizes[i];
+    }
+    set_cuts_valid(g, player, old_area, false);
+}
+
+/** @brief Sprawdza czy pole sąsiada należy do gracza
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] player   – numer gracza,
+ * @param[in] x   – współrzędna x pola, może wychodzić poza planszę,
+ * @param[in] y   – współrzędna y pola, może wychodzić poza planszę,
+ * @return Zwraca true jeśli pole leży na planszy i należy do gracza.
+ */
+
+static bool ring_owned(const gamma_t *g, uint32_t player, int64_t x, int64_t y)
+{
+    return x >= 0 && y >= 0 && x < g->max_width && y < g->max_height
+           && get_owner(g, (uint32_t) x, (uint32_t) y) == player;
+}
+
+uint32_t area_local_pieces(const gamma_t *g, uint32_t x, uint32_t y)
+{
+    // Pola otaczające po kolei, parzyste pozycje to sąsiedzi bokiem.
+    static const int8_t ring_x[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+    static const int8_t ring_y[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    uint32_t player = get_owner(g, x, y);
+    bool owned[8];
+    uint32_t members = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        owned[i] = ring_owned(g, player, (int64_t) x + ring_x[i], (int64_t) y + ring_y[i]);
+        members += owned[i];
+    }
+    if (members == 8)
+        return 1;
+
+    // Liczymy łuki pól gracza na pierścieniu, które zawierają sąsiada bokiem,
+    // zaczynając od pola spoza obszaru, żeby żaden łuk nie był przecięty.
+    int start = 0;
+    while (owned[start])
+        start++;
+    uint32_t arcs = 0;
+    bool side = false;
+    for (int k = 1; k <= 8; k++)
+    {
+        int i = (start + k) % 8;
+        if (owned[i])
+        {
+            side = side || i % 2 == 0;
+            continue;
+        }
+        arcs += side;
+        side = false;
+    }
+    return arcs;
+}
+
+uint32_t area_count_pieces(gamma_t *g, uint32_t x, uint32_t y)
+{
+    uint32_t local = area_local_pieces(g, x, y);
+    if (local <= 1)
+        return local;
+
+    uint64_t index = field_index(g, x, y);
+    uint32_t owner = owner_at(g, index);
+    uint32_t area = area_root(g, owner, area_at(g, index));
+    uint64_t size = g->player_info[owner].area_size[area];
+
+    if (!cuts_valid(g, owner, area))
+    {
+        count_area_pieces(g, owner, index, size);
+        set_cuts_valid(g, owner, area, true);
+    }
+    return cut_pieces(g, index, size);
+}
+
+bool area_pieces_known(const gamma_t *g, uint32_t x, uint32_t y)
+{
+    uint64_t index = field_index(g, x, y);
+    uint32_t owner = owner_at(g, index);
+    return cuts_valid(g, owner, area_root(g, owner, area_at(g, index)));
+}
+
+void area_delete_caches(gamma_t *g)
+{
+    if (g->cut_caches == NULL)
+        return;
+    for (uint32_t i = 0; i < g->players + 1; i++)
+    {
+        free(g->cut_caches[i].valid);
+    }
+    free(g->cut_caches);
+    g->cut_caches = NULL;
+}
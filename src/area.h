@@ -0,0 +1,148 @@
+/** @file
+ * Interfejs klasy przechowującej obszary graczy w postaci lasu numerów obszarów
+ *
+ * Każde zajęte pole przechowuje numer obszaru, a numery tworzą las zbiorów
+ * rozłącznych: obszar jest wyznaczony przez korzeń, do którego prowadzi
+ * numer pola. Przy łączeniu obszarów korzenie mniejszych są podpinane pod
+ * korzeń największego bez zmieniania numerów w polach. Numery zmieniają
+ * tylko pola mniejszych części obszaru rozbitego złotym ruchem.
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 24.05.2020
+ */
+
+#ifndef GAMMA_AREA_H
+#define GAMMA_AREA_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include "gamma.h"
+#include "gamma_t.h"
+
+/** @brief Dołącza pole do obszarów gracza
+ * Jeśli pole nie ma sąsiadów gracza, to tworzy dla niego nowy obszar.
+ * W przeciwnym wypadku łączy wszystkie sąsiednie obszary, podpinając
+ * korzenie mniejszych pod korzeń największego (łączenie według rozmiaru),
+ * więc ścieżka od numeru pola do korzenia ma długość O(log n).
+ * Aktualizuje liczbę obszarów gracza.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ */
+
+void area_add_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+
+/**
+  * Części, na które rozpada się obszar po zabraniu z niego pola.
+  */
+
+typedef struct area_split
+{
+    uint64_t starts[4]; ///< indeksy sąsiadów pola należących do gracza
+    uint64_t sizes[4]; ///< rozmiary części przejrzanych w całości (zob. @ref split_area)
+    uint32_t count; ///< liczba sąsiadów pola należących do gracza
+} area_split_t;
+
+/** @brief Znajduje części, na które rozpadnie się obszar po zabraniu pola
+ * Pole może jeszcze należeć do gracza. Największa część nie jest
+ * przeglądana do końca (zob. @ref split_area).
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks właściciela obszaru,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @param[out] split   – znalezione części,
+ * @return Zwraca liczbę części, 0 jeśli obszar składa się tylko z tego pola.
+ */
+
+uint32_t area_split_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, area_split_t *split);
+
+/** @brief Usuwa pole z obszaru gracza przy złotym ruchu
+ * Pole musi już mieć nowego właściciela. Obszar, do którego należało,
+ * zostaje rozbity na spójne części. Największa z nich zachowuje korzeń
+ * obszaru i nie jest przeglądana do końca, a pozostałe dostają nowe numery
+ * (zob. @ref split_area), więc koszt zależy od rozmiaru mniejszych części.
+ * Aktualizuje liczbę obszarów gracza.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks poprzedniego właściciela pola,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @param[in] split   – części znalezione wcześniej przez @ref area_split_field
+ * lub NULL, jeśli trzeba je znaleźć,
+ */
+
+void area_remove_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, const area_split_t *split);
+
+/** @brief Znajduje korzeń obszaru gracza
+ * Nie zmienia lasu numerów, więc może być używana przez kopie gry
+ * współdzielące tablice gracza.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] area_number   – numer obszaru zapisany w polu gracza,
+ * @return Zwraca numer korzenia obszaru.
+ */
+
+uint32_t area_root(const gamma_t *g, uint32_t player, uint32_t area_number);
+
+/** @brief Nadaje polu gracza nowy numer obszaru
+ * Odejmuje odwołanie do dotychczasowego numeru pola, zwalniając numery,
+ * do których nic się już nie odwołuje. Zmiany są zapisywane w dzienniku.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] index   – indeks pola gracza,
+ * @param[in] area_number   – nowy numer obszaru pola,
+ */
+
+void area_relabel_field(gamma_t *g, uint32_t player, uint64_t index, uint32_t area_number);
+
+/** @brief Zapamiętuje na ile części rozpadnie się obszar po zabraniu z niego pola
+ * Zmiana wartości pieces pola jest zapisywana w dzienniku.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks zajętego pola,
+ * @param[in] pieces   – liczba spójnych części,
+ */
+
+void area_set_pieces(gamma_t *g, uint64_t index, uint32_t pieces);
+
+/** @brief Szacuje z otoczenia pola na ile części rozpadnie się jego obszar
+ * Liczy łuki pól tego samego gracza na pierścieniu ośmiu pól wokół danego,
+ * które zawierają sąsiada bokiem. Sąsiedzi w jednym łuku pozostają połączeni,
+ * więc wynik ogranicza liczbę części z góry i jest dokładny, gdy nie przekracza 1.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x zajętego pola,
+ * @param[in] y   – współrzędna y zajętego pola,
+ * @return Zwraca liczbę łuków, 0 jeśli pole nie ma sąsiadów tego samego gracza.
+ */
+
+uint32_t area_local_pieces(const gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Podaje na ile części rozpadnie się obszar po zabraniu z niego pola
+ * Wyniki są pamiętane dla wszystkich pól obszaru i liczone od nowa tylko
+ * wtedy, gdy obszar zmienił się od ostatniego liczenia w sposób, który może
+ * zmienić jego punkty artykulacji. Dołączenie pola stykającego się z każdym
+ * sąsiednim obszarem jednym bokiem i zmiany innych obszarów ich nie unieważniają.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x zajętego pola,
+ * @param[in] y   – współrzędna y zajętego pola,
+ * @return Zwraca liczbę spójnych części, 0 jeśli obszar składa się tylko z tego pola.
+ */
+
+uint32_t area_count_pieces(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Sprawdza czy liczby części pól obszaru są zapamiętane i aktualne
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x zajętego pola,
+ * @param[in] y   – współrzędna y zajętego pola,
+ * @return Zwraca true jeśli @ref area_count_pieces nie musi przechodzić obszaru, false w przeciwnym wypadku.
+ */
+
+bool area_pieces_known(const gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Zwalnia pamięć punktów artykulacji wszystkich graczy
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ */
+
+void area_delete_caches(gamma_t *g);
+
+#endif //GAMMA_AREA_H
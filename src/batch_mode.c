@@ -8,20 +8,62 @@
 
 #define _GNU_SOURCE
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "batch_mode.h"
 #include "input.h"
+#include "output.h"
+#include "ring.h"
 #include "gamma_t.h"
 #include "gamma.h"
 
-/** @brief Funkcja sprawdza poprawność komendy i wywołuje odpowiednią
- * Funkcja najpierw sprawdza czy zgadza się liczba słów do danej komendy,
- * jeśli tak to wypisuje jej wynik.
+/** Liczba elementów kolejek między wątkami potoku */
+#define PIPELINE_RING_SIZE 4096
+/** Minimalna liczba procesorów, przy której tryb wsadowy używa potoku */
+#define PIPELINE_MIN_PROCESSORS 3
+/** Zmienna środowiskowa włączająca potok w trybie wsadowym */
+#define PIPELINE_ENVIRONMENT "GAMMA_PIPELINE"
+
+bool batch_execute(gamma_t *g, char command, const uint32_t *parameters, uint64_t *result)
+{
+    uint32_t player = parameters[0];
+    uint32_t x = parameters[1];
+    uint32_t y = parameters[2];
+
+    switch(command)
+    {
+        case 'm':
+            *result = gamma_move(g, player, x, y);
+            return true;
+        case 'g':
+            *result = gamma_golden_move(g, player, x, y);
+            return true;
+        case 'b':
+            *result = gamma_busy_fields(g, player);
+            return true;
+        case 'f':
+            *result = gamma_free_fields(g, player);
+            return true;
+        case 'q':
+            *result = gamma_golden_possible(g, player);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** @brief Sprawdza poprawność komendy i wczytuje jej parametry
+ * @param[in] command   – litera komendy,
+ * @param[in] string   – reszta wiersza po literze komendy,
+ * @param[in] length   – długość reszty wiersza,
+ * @param[out] parameters   – tablica na trzy parametry komendy,
+ * @return Zwraca true jeśli komenda jest poprawna, false w przeciwnym wypadku.
  */
 
-static void choose_command(gamma_t *g, uint32_t line, char *string, char command)
+static bool parse_command(char command, const char *string, size_t length, uint32_t *parameters)
 {
     uint32_t correct_number_of_words = 0;
 
@@ -30,75 +72,250 @@ static void choose_command(gamma_t *g, uint32_t line, char *string, char command
     else if(command == 'b' || command == 'f' || command == 'q')
         correct_number_of_words = 1;
     else if(command != 'p')
+        return false;
+
+    parameters[0] = parameters[1] = parameters[2] = 0;
+    return parse_parameters(string, length, correct_number_of_words, parameters);
+}
+
+/** @brief Funkcja sprawdza poprawność komendy i wywołuje odpowiednią
+ * Funkcja najpierw sprawdza czy zgadza się liczba słów do danej komendy,
+ * jeśli tak to dopisuje jej wynik do bufora wyjścia.
+ */
+
+static void choose_command(gamma_t *g, output_t *output, uint32_t line, const char *string, size_t length, char command)
+{
+    uint32_t parameters[3];
+    if(!parse_command(command, string, length, parameters))
     {
-        fprintf(stderr, "ERROR %u\n", line);
+        output_error(output, line);
         return;
     }
 
-    if(!isNumberOfWordsCorrect(string, correct_number_of_words))
+    if (command == 'p')
     {
-        fprintf(stderr, "ERROR %u\n", line);
-        return;
+        output_flush(output);
+        gamma_board_print(g, stdout);
+        fflush(stdout);
+    }
+    else
+    {
+        uint64_t result = 0;
+        batch_execute(g, command, parameters, &result);
+        output_number(output, result);
     }
+}
 
-    bool error = false;
-    uint32_t x = 0, y = 0;
-    uint32_t player = word_to_int(&string, &error);
-    if (command == 'm' || command == 'g')
+/**
+ * Rodzaj elementu przekazywanego między etapami potoku.
+ */
+
+typedef enum item_kind
+{
+    ITEM_COMMAND, ///< poprawna komenda do wykonania
+    ITEM_ERROR, ///< niepoprawna komenda
+    ITEM_RESULT, ///< wynik wykonanej komendy
+    ITEM_BOARD, ///< prośba o opróżnienie bufora przed wypisaniem planszy
+    ITEM_END ///< koniec wejścia
+} item_kind_t;
+
+/**
+ * Element przekazywany między etapami potoku.
+ */
+
+typedef struct pipeline_item
+{
+    item_kind_t kind; ///< rodzaj elementu
+    char command; ///< litera komendy
+    uint32_t line; ///< numer wiersza z komendą
+    uint32_t parameters[3]; ///< parametry komendy
+    uint64_t result; ///< wynik komendy
+} pipeline_item_t;
+
+/**
+ * Stan potoku trybu wsadowego. Wątek wczytujący przekazuje komendy
+ * wątkowi głównemu, który je wykonuje i przekazuje wyniki wątkowi
+ * wypisującemu.
+ */
+
+typedef struct pipeline
+{
+    ring_t commands; ///< kolejka komend od wątku wczytującego
+    ring_t results; ///< kolejka wyników dla wątku wypisującego
+    ring_t flushed; ///< kolejka potwierdzeń opróżnienia bufora wyjścia
+    output_t output; ///< bufor wyjścia używany przez wątek wypisujący
+    uint32_t line; ///< numer wiersza z nagłówkiem
+} pipeline_t;
+
+/** @brief Główna funkcja wątku wczytującego komendy
+ * @param[in, out] arg   – stan potoku,
+ * @return NULL.
+ */
+
+static void *read_stage(void *arg)
+{
+    pipeline_t *p = arg;
+    line_reader_t reader;
+    const char *string;
+    size_t length;
+    uint32_t line = p->line;
+
+    reader_open(&reader, stdin);
+    while (reader_next_line(&reader, &string, &length))
     {
-        x = word_to_int(&string, &error);
-        y = word_to_int(&string, &error);
+        line++;
+
+        if (*string == '#' || *string == '\n')
+            continue;
+
+        pipeline_item_t item = {ITEM_COMMAND, *string, line, {0, 0, 0}, 0};
+        if (!parse_command(*string, string + 1, length - 1, item.parameters))
+            item.kind = ITEM_ERROR;
+        ring_push(&p->commands, &item);
     }
+    reader_close(&reader);
 
-    if(error)
+    pipeline_item_t end = {ITEM_END, 0, line, {0, 0, 0}, 0};
+    ring_push(&p->commands, &end);
+    return NULL;
+}
+
+/** @brief Główna funkcja wątku wypisującego wyniki
+ * @param[in, out] arg   – stan potoku,
+ * @return NULL.
+ */
+
+static void *write_stage(void *arg)
+{
+    pipeline_t *p = arg;
+    pipeline_item_t item;
+    char confirmation = 1;
+
+    while (true)
     {
-        fprintf(stderr, "ERROR %u\n", line);
-        return;
+        ring_pop(&p->results, &item);
+        switch (item.kind)
+        {
+            case ITEM_RESULT:
+                output_number(&p->output, item.result);
+                break;
+            case ITEM_ERROR:
+                output_error(&p->output, item.line);
+                break;
+            case ITEM_BOARD:
+                output_flush(&p->output);
+                ring_push(&p->flushed, &confirmation);
+                break;
+            case ITEM_END:
+                output_flush(&p->output);
+                return NULL;
+            case ITEM_COMMAND:
+                break;
+        }
     }
-    char *board;
+}
 
-    switch(command)
+/** @brief Obsługuje tryb wsadowy przy użyciu trzech wątków
+ * Komendy są wczytywane, wykonywane i wypisywane jednocześnie,
+ * a wyniki są wypisywane w tej samej kolejności co bez potoku.
+ * Plansza jest wypisywana przez wątek główny po opróżnieniu bufora
+ * przez wątek wypisujący.
+ * @param[in, out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] line   – numer wiersza z nagłówkiem,
+ * @return Zwraca true jeśli obsłużono całe wejście, false jeśli nie udało
+ * się uruchomić wątków i nic nie zostało wczytane.
+ */
+
+static bool batch_pipeline(gamma_t *g, uint32_t line)
+{
+    pipeline_t p;
+    ring_init(&p.commands, sizeof(pipeline_item_t), PIPELINE_RING_SIZE);
+    ring_init(&p.results, sizeof(pipeline_item_t), PIPELINE_RING_SIZE);
+    ring_init(&p.flushed, sizeof(char), 1);
+    output_open(&p.output);
+    p.line = line;
+
+    pthread_t reader, writer;
+    bool started = false;
+    if (pthread_create(&writer, NULL, write_stage, &p) == 0)
     {
-        case 'm':
-            printf("%d\n", gamma_move(g, player, x, y));
-            break;
-        case 'g':
-            printf("%d\n", gamma_golden_move(g, player, x, y));
-            break;
-        case 'b':
-            printf("%lu\n", gamma_busy_fields(g, player));
-            break;
-        case 'f':
-            printf("%lu\n", gamma_free_fields(g, player));
-            break;
-        case 'q':
-            printf("%d\n", gamma_golden_possible(g, player));
-            break;
-        case 'p':
-            board = gamma_board(g);
-            printf("%s", board);
-            free(board);
-            break;
+        started = pthread_create(&reader, NULL, read_stage, &p) == 0;
+        if (!started)
+        {
+            pipeline_item_t end = {ITEM_END, 0, line, {0, 0, 0}, 0};
+            ring_push(&p.results, &end);
+        }
+        else
+        {
+            pipeline_item_t item;
+            do
+            {
+                ring_pop(&p.commands, &item);
+                if (item.kind == ITEM_COMMAND && item.command == 'p')
+                {
+                    char confirmation;
+                    item.kind = ITEM_BOARD;
+                    ring_push(&p.results, &item);
+                    ring_pop(&p.flushed, &confirmation);
+                    gamma_board_print(g, stdout);
+                    fflush(stdout);
+                    continue;
+                }
+                if (item.kind == ITEM_COMMAND)
+                {
+                    batch_execute(g, item.command, item.parameters, &item.result);
+                    item.kind = ITEM_RESULT;
+                }
+                ring_push(&p.results, &item);
+            } while (item.kind != ITEM_END);
+            pthread_join(reader, NULL);
+        }
+        pthread_join(writer, NULL);
     }
+
+    output_close(&p.output);
+    ring_free(&p.flushed);
+    ring_free(&p.results);
+    ring_free(&p.commands);
+    return started;
+}
+
+/** @brief Sprawdza, czy tryb wsadowy ma używać potoku
+ * Potok jest włączany tylko na żądanie, przez ustawienie zmiennej
+ * środowiskowej @ref PIPELINE_ENVIRONMENT na wartość różną od "0",
+ * i tylko gdy dostępne są co najmniej @ref PIPELINE_MIN_PROCESSORS procesory.
+ * @return Zwraca true jeśli należy użyć potoku, false w przeciwnym wypadku.
+ */
+
+static bool pipeline_enabled()
+{
+    const char *value = getenv(PIPELINE_ENVIRONMENT);
+    if (!value || *value == '\0' || strcmp(value, "0") == 0)
+        return false;
+    return sysconf(_SC_NPROCESSORS_ONLN) >= PIPELINE_MIN_PROCESSORS;
 }
 
 void batch_mode(gamma_t *g, uint32_t line)
 {
-    char *string = NULL;
-    size_t size = 0;
+    if (pipeline_enabled() && batch_pipeline(g, line))
+        return;
 
-    while (getline(&string, &size, stdin) != -1)
+    line_reader_t reader;
+    output_t output;
+    const char *string;
+    size_t length;
+
+    reader_open(&reader, stdin);
+    output_open(&output);
+    while (reader_next_line(&reader, &string, &length))
     {
         line++;
-        char *temp = string;
 
-        if (*temp == '#' || *temp == '\n')
+        if (*string == '#' || *string == '\n')
             continue;
 
-        char mode = *temp;
-        temp++;
-
-        choose_command(g, line, temp, mode);
+        choose_command(g, &output, line, string + 1, length - 1, *string);
     }
-    free(string);
+    output_close(&output);
+    reader_close(&reader);
 }
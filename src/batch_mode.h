@@ -8,10 +8,27 @@
 
 #ifndef GAMMA_BATCH_MODE_H
 #define GAMMA_BATCH_MODE_H
+#include <stdbool.h>
 #include "gamma.h"
 
+/** @brief Wykonuje komendę zwracającą liczbę
+ * Obsługuje komendy m, g, b, f i q, wspólne dla trybu wsadowego
+ * i binarnego.
+ * @param[in, out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] command   – litera komendy,
+ * @param[in] parameters   – numer gracza i ewentualnie współrzędne pola,
+ * @param[out] result   – wynik komendy,
+ * @return Zwraca true jeśli komenda została wykonana, false jeśli
+ * litera nie oznacza żadnej z obsługiwanych komend.
+ */
+
+bool batch_execute(gamma_t *g, char command, const uint32_t *parameters, uint64_t *result);
+
 /** @brief Główna funkcja obsługująca tryb wsadowy
  * Funkcja zawiera pętlę obsługującą input w trybie wsadowym.
+ * Domyślnie komendy są obsługiwane sekwencyjnie; potok trzech wątków
+ * jest używany tylko, gdy zmienna środowiskowa GAMMA_PIPELINE ma wartość
+ * różną od "0".
  */
 
 void batch_mode(gamma_t *g, uint32_t line);
@@ -10,518 +10,348 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include "area.h"
 #include "bfs.h"
-
-/**
-  * Struktura implementująca listę.
-  */
-
-typedef struct list
-{
-    coords_t data; ///< Wartość elementu
-    struct list *next; ///< Wskaźnik na następny element w liście
-} list_t;
-
-/**
-  * Struktura implementująca kolejkę.
-  */
-
-typedef struct queue
-{
-    list_t *begin; ///< Wskaźnik na początek kolejki
-    list_t *end; ///< Wskaźnik na koniec kolejki
-} queue_t;
+#include "board.h"
+#include "journal.h"
 
 /** @brief Sprawdza czy kolejka jest pusta
  * @param[in] q   – wskaźnik na kolejkę
- * @return Zwraca true jeśli q jest NULLem, false w przeciwnym wypadku.
+ * @return Zwraca true jeśli kolejka nie ma elementów, false w przeciwnym wypadku.
  */
 
 static bool queue_empty(queue_t *q)
 {
-    return (q->begin == NULL);
+    return (q->size == 0);
 }
 
-/** @brief Inicjalizuje kolejkę
- * Ustawia początek kolejki na NULL.
+/** @brief Opróżnia kolejkę
+ * Zostawia zaalokowany bufor, aby kolejne przejścia nie alokowały pamięci.
  * @param[in] q   – wskaźnik na kolejkę
  */
 
 static void queue_initialize(queue_t *q)
 {
-    q->begin = NULL;
-}
-
-
-/** @brief Wstawia do kolejki ZA podany element
- * Alokuje pamięć na nowy element i wstawia go do kolejki za element @p x.
- * @param[in] l   – wskaźnik na listę,
- * @param[in] x  – element za który wstawia.
- */
-static void queue_insert_behind(list_t *l, coords_t x)
-{
-    list_t *temp = malloc(sizeof(list_t));
-    checkNull(temp);
-    temp->next = l->next;
-    temp->data = x;
-    l->next = temp;
+    q->begin = 0;
+    q->size = 0;
 }
 
 /** @brief Wstawia do kolejki podany element
- * Alokuje pamięć jeśli kolejka jest pusta lub wstawia za ostatni element jeśli nie jest pusta.
+ * Jeśli bufor jest pełny to podwaja jego rozmiar, przenosząc elementy
+ * zawinięte na początek bufora za pozostałe.
  * @param[in] q   – wskaźnik na kolejkę
- * @param[in] x  – element który wstawia.
+ * @param[in] index  – indeks pola który wstawia.
  */
 
-static void queue_insert(queue_t *q, coords_t x)
+static void queue_insert(queue_t *q, uint64_t index)
 {
-    if (q->begin == NULL)
-    {
-        q->begin = malloc(sizeof(list_t));
-        checkNull(q->begin);
-        q->begin->data = x;
-        q->end = q->begin;
-    }
-    else
+    if (q->size == q->capacity)
     {
-        queue_insert_behind(q->end, x);
-        q->end = q->end->next;
+        uint64_t capacity = q->capacity == 0 ? 64 : 2 * q->capacity;
+        uint64_t *buffer = realloc(q->buffer, capacity * sizeof(uint64_t));
+        checkNull(buffer);
+        memcpy(buffer + q->capacity, buffer, q->begin * sizeof(uint64_t));
+        q->buffer = buffer;
+        q->capacity = capacity;
     }
+    q->buffer[(q->begin + q->size) & (q->capacity - 1)] = index;
+    (q->size)++;
 }
 
 /** @brief Pobiera pierwszy element z kolejki
- * Alokuje pamięć jeśli kolejka jest pusta lub wstawia za ostatni element jeśli nie jest pusta.
- * @param[in] q   – wskaźnik na kolejkę
+ * @param[in] q   – wskaźnik na niepustą kolejkę
  * @return Zwraca pierwszy element z kolejki
  */
 
-static coords_t queue_get(queue_t *q)
+static uint64_t queue_get(queue_t *q)
 {
-    list_t *temp = q->begin;
-    coords_t x = q->begin->data;
-    if (q->begin == q->end)
-        q->begin = NULL;
-    else
-        q->begin = q->begin->next;
-    free(temp);
-    return x;
+    uint64_t index = q->buffer[q->begin];
+    q->begin = (q->begin + 1) & (q->capacity - 1);
+    (q->size)--;
+    return index;
 }
 
-/** @brief Zwalnia całą kolejkę
- * @param[in] q   – wskaźnik na kolejkę
- */
-
-static void queue_free(queue_t *q)
-{
-    while (!queue_empty(q))
-        queue_get(q);
-}
-
-/** @brief Sprawdza czy podane pole należy do tego samego gracza
+/** @brief Zwraca pamięć pomocniczą gry o co najmniej podanym rozmiarze
+ * Powiększa pamięć tylko wtedy, gdy obecna jest za mała.
  * @param[in, out] g   – struktura przechowująca stan gry,
- * @param[in] player   – indeks gracza,
- * @param[in] x   – współrzędna x pola,
- * @param[in] y   – współrzędna y pola,
- */
-
-static bool check_if_same_player(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
-{
-    if ((*(g->board))[x][y].visited == false
-        && (*(g->board))[x][y].owner == player)
-        return true;
-    return false;
-}
-
-/** @brief Zwraca większą z dwóch podanych liczb
- * @param[in] a   – pierwsza liczba,
- * @param[in] b   – druga liczba,
- * @return Zwraca a jeśli a > b lub b w przeciwnym wypadku.
+ * @param[in] size   – potrzebny rozmiar w bajtach,
+ * @return Wskaźnik na pamięć pomocniczą.
  */
 
-static uint32_t max(uint32_t a, uint32_t b)
+static void *get_scratch(gamma_t *g, size_t size)
 {
-    return (a > b ? a : b);
+    if (g->scratch_size < size)
+    {
+        free(g->scratch);
+        g->scratch = malloc(size);
+        checkNull(g->scratch);
+        g->scratch_size = size;
+    }
+    return g->scratch;
 }
 
-/** @brief Funkcja pomocnicza do wstawiania koordynatów pola do kolejki bfsa
- * @param[in, out] q   – wskaźnik na kolejkę,
- * @param[in] x   – współrzędna x pola,
- * @param[in] y   – współrzędna y pola,
+/** @brief Zwraca indeks sąsiada pola w podanym kierunku
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks pola,
+ * @param[in] direction   – kierunek (0 – lewo, 1 – prawo, 2 – dół, 3 – góra),
+ * @param[out] neighbour   – indeks sąsiada,
+ * @return Zwraca false jeśli w tym kierunku jest koniec planszy, true w przeciwnym wypadku.
  */
 
-static void queue_insert_field(queue_t *q, uint32_t x, uint32_t y)
+static bool neighbour_index(gamma_t *g, uint64_t index, uint32_t direction, uint64_t *neighbour)
 {
-    coords_t *neighbour = malloc(sizeof(coords_t));
-    checkNull(neighbour);
-    (*neighbour).x = x;
-    (*neighbour).y = y;
-    queue_insert(q, *neighbour);
-    free(neighbour);
+    uint32_t x = index % g->max_width;
+    uint32_t y = index / g->max_width;
+    switch (direction)
+    {
+        case 0:
+            if (x == 0)
+                return false;
+            *neighbour = index - 1;
+            return true;
+        case 1:
+            if (x == g->max_width - 1)
+                return false;
+            *neighbour = index + 1;
+            return true;
+        case 2:
+            if (y == 0)
+                return false;
+            *neighbour = index - g->max_width;
+            return true;
+        default:
+            if (y == g->max_height - 1)
+                return false;
+            *neighbour = index + g->max_width;
+            return true;
+    }
 }
 
-/** @brief Przechodzi bfsem pola resetując przy tym flagi odwiedzenia
+/** @brief Rozpoczyna kilka przejść planszy naraz
+ * Rezerwuje @p count kolejnych numerów przejść, więc wszystkie pola
+ * z numerem mniejszym od pierwszego z nich są nieodwiedzone bez
+ * przechodzenia po nich. Tylko po przekręceniu się licznika zeruje
+ * numery wszystkich pól.
  * @param[in, out] g   – struktura przechowująca stan gry,
- * @param[in] coordinates   – współrzędne pola od którego zaczyna resetowanie,
+ * @param[in] count   – liczba przejść,
+ * @return Numer pierwszego z przejść.
  */
 
-static void reset_visited(gamma_t *g, coords_t coordinates)
+static uint32_t new_visits(gamma_t *g, uint32_t count)
 {
-    queue_t *q = malloc(sizeof(queue_t));
-    checkNull(q);
-    queue_initialize(q);
-    queue_insert(q, coordinates);
-
-    (*(g->board))[coordinates.x][coordinates.y].visited = false;
-
-    while (!queue_empty(q))
+    // Po przekręceniu licznika stare numery mogłyby udawać bieżące przejście.
+    if (g->visit_epoch > UINT32_MAX - count)
     {
-        coords_t coords = queue_get(q);
-        uint32_t x = coords.x;
-        uint32_t y = coords.y;
-        if (x > 0 && (*(g->board))[x - 1][y].visited == true)
-        {
-            (*(g->board))[x - 1][y].visited = false;
-            queue_insert_field(q, x - 1, y);
-        }
-
-        if (x < g->max_width - 1 && (*(g->board))[x + 1][y].visited == true)
-        {
-            (*(g->board))[x + 1][y].visited = false;
-            queue_insert_field(q, x + 1, y);
-        }
-
-        if (y > 0 && (*(g->board))[x][y - 1].visited == true)
-        {
-            (*(g->board))[x][y - 1].visited = false;
-            queue_insert_field(q, x, y - 1);
-        }
-
-        if (y < g->max_height - 1 && (*(g->board))[x][y + 1].visited == true)
-        {
-            (*(g->board))[x][y + 1].visited = false;
-            queue_insert_field(q, x, y + 1);
-        }
+        board_clear_visits(g);
+        g->visit_epoch = 0;
     }
-    free(q);
+    uint32_t first = g->visit_epoch + 1;
+    g->visit_epoch += count;
+    return first;
 }
 
-uint32_t count_areas(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+void count_area_pieces(gamma_t *g, uint32_t player, uint64_t root, uint64_t size)
 {
-    uint32_t up = 0, left = 0, right = 0, down = 0;
-    if (x < g->max_width - 1 && (*(g->board))[x + 1][y].owner == player)
-        right = (*(g->board))[x + 1][y].area;
-
-    if (x > 0 && (*(g->board))[x - 1][y].owner == player)
-        left = (*(g->board))[x - 1][y].area;
-
-    if (y < g->max_height - 1 && (*(g->board))[x][y + 1].owner == player)
-        up = (*(g->board))[x][y + 1].area;
-
-    if (y > 0 && (*(g->board))[x][y - 1].owner == player)
-        down = (*(g->board))[x][y - 1].area;
-
-    uint32_t counter = 1;
-    uint32_t array[4] = {up, left, right, down};
-
-    for (uint32_t i = 0; i < 4; i++)
-        if (array[i] == 0)
-        {
-            counter--;
-            break;
-        }
-
-    for (uint32_t i = 1; i < 4; i++)
+    // Stos indeksów pól, low i liczby części według numeru pola w kolejności
+    // odwiedzania oraz kierunki według głębokości stosu zajmują 14 bajtów na pole.
+    uint64_t *stack = get_scratch(g, size * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(uint8_t)));
+    uint32_t *low = (uint32_t *) (stack + size);
+    uint8_t *direction = (uint8_t *) (low + size);
+    uint8_t *pieces = direction + size;
+
+    // Każde pole dostaje własny numer przejścia, więc numer pola w kolejności
+    // odwiedzania to jego numer przejścia pomniejszony o pierwszy z nich.
+    uint32_t first = new_visits(g, (uint32_t) size);
+    uint64_t top = 0;
+    uint32_t order = 0;
+
+    // Korzeń dfsa rozpada się na tyle części ile ma dzieci, pozostałe pola
+    // na jedną część z rodzicem plus po jednej za każde dziecko, z którego
+    // poddrzewa nie ma krawędzi powrotnej nad to pole.
+    *visit_at(g, root) = first;
+    pieces[order] = 0;
+    low[order++] = 0;
+    direction[top] = 0;
+    stack[top++] = root;
+
+    while (top > 0)
     {
-        uint32_t j = 0;
-        for (j = 0; j < i; j++)
-            if (array[i] == array[j])
-                break;
-
-        if (i == j)
-            counter++;
-    }
-
-    return counter;
-}
-
-bool bfs(gamma_t *g, uint32_t player, coords_t begin, coords_t end, uint32_t area_number)
-{
-    if (begin.x == end.x && begin.y == end.y)
-        return true;
-    queue_t *q = malloc(sizeof(queue_t));
-    checkNull(q);
-    queue_initialize(q);
-    queue_insert(q, begin);
+        uint64_t index = stack[top - 1];
+        uint32_t field = *visit_at(g, index) - first;
+        uint64_t next;
 
-    (*(g->board))[begin.x][begin.y].visited = true;
-
-    while (!queue_empty(q))
-    {
-        coords_t coords = queue_get(q);
-        uint32_t x = coords.x;
-        uint32_t y = coords.y;
-        if (x > 0 && (*(g->board))[x - 1][y].visited == false
-            && (*(g->board))[x - 1][y].owner == player && (*(g->board))[x - 1][y].area == area_number)
+        if (direction[top - 1] < 4)
         {
-            if (x - 1 == end.x && y == end.y)
-            {
-                queue_free(q);
-                free(q);
-                reset_visited(g, begin);
-                return true;
-            }
-            (*(g->board))[x - 1][y].visited = true;
-            queue_insert_field(q, x - 1, y);
-        }
+            if (!neighbour_index(g, index, (direction[top - 1])++, &next) || owner_at(g, next) != player)
+                continue;
 
-        if (x < g->max_width - 1 && (*(g->board))[x + 1][y].visited == false
-            && (*(g->board))[x + 1][y].owner == player && (*(g->board))[x + 1][y].area == area_number)
-        {
-            if (x + 1 == end.x && y == end.y)
+            uint32_t *visit = visit_at(g, next);
+            uint32_t neighbour = *visit - first;
+            if (neighbour < order)
             {
-                queue_free(q);
-                free(q);
-                reset_visited(g, begin);
-                return true;
+                if (neighbour < low[field])
+                    low[field] = neighbour;
+                continue;
             }
-            (*(g->board))[x + 1][y].visited = true;
-            queue_insert_field(q, x + 1, y);
-        }
 
-        if (y > 0 && (*(g->board))[x][y - 1].visited == false
-            && (*(g->board))[x][y - 1].owner == player && (*(g->board))[x][y - 1].area == area_number)
-        {
-            if (x == end.x && y - 1 == end.y)
-            {
-                queue_free(q);
-                free(q);
-                reset_visited(g, begin);
-                return true;
-            }
-            (*(g->board))[x][y - 1].visited = true;
-            queue_insert_field(q, x, y - 1);
+            *visit = first + order;
+            pieces[order] = 1;
+            low[order] = order;
+            order++;
+            direction[top] = 0;
+            stack[top++] = next;
         }
-
-        if (y < g->max_height - 1 && (*(g->board))[x][y + 1].visited == false
-            && (*(g->board))[x][y + 1].owner == player && (*(g->board))[x][y + 1].area == area_number)
+        else
         {
-            if (x == end.x && y + 1 == end.y)
-            {
-                queue_free(q);
-                free(q);
-                reset_visited(g, begin);
-                return true;
-            }
-            (*(g->board))[x][y + 1].visited = true;
-            queue_insert_field(q, x, y + 1);
+            // Wszystkie dzieci pola są już policzone, więc jego wynik jest ostateczny.
+            area_set_pieces(g, index, pieces[field]);
+            top--;
+            if (top == 0)
+                break;
+            uint32_t parent = *visit_at(g, stack[top - 1]) - first;
+            if (low[field] < low[parent])
+                low[parent] = low[field];
+            if (low[field] >= parent)
+                (pieces[parent])++;
         }
     }
-    reset_visited(g, begin);
-    free(q);
-    return false;
 }
 
-/** @brief Ustawia indeksy obszaru na nowy w przypadku złączania obszarów
- * Przechodzi za pomocą bfsa dany obszar i zmienia wartość area w każdym z napotkanych pól.
+/** @brief Nadaje polu nowy numer obszaru i wstawia je do kolejki
  * @param[in, out] g   – struktura przechowująca stan gry,
- * @param[in] coordinates   – współrzędne początkowego pola,
  * @param[in] player   – indeks gracza,
- * @param[in] new_area_number  – indeks nowego obszaru,
+ * @param[in] index   – indeks pola,
+ * @param[in] new_area_number  – nowy numer obszaru,
  */
 
-static void set_new_area_number(gamma_t *g, coords_t coordinates, uint32_t player, uint32_t new_area_number)
+static void relabel_field(gamma_t *g, uint32_t player, uint64_t index, uint32_t new_area_number)
 {
-    if (coordinates.x >= g->max_width || coordinates.y >= g->max_height
-        || (*(g->board))[coordinates.x][coordinates.y].owner != player)
-        return;
+    area_relabel_field(g, player, index, new_area_number);
+    queue_insert(&g->queues[0], index);
+}
 
-    queue_t *q = malloc(sizeof(queue_t));
-    checkNull(q);
+void relabel_area(gamma_t *g, uint64_t start, uint32_t player, uint32_t old_area_number, uint32_t new_area_number)
+{
+    queue_t *q = &g->queues[0];
     queue_initialize(q);
+    relabel_field(g, player, start, new_area_number);
 
-    queue_insert(q, coordinates);
-
-    (*(g->board))[coordinates.x][coordinates.y].visited = true;
-    (*(g->board))[coordinates.x][coordinates.y].area = new_area_number;
-
+    // Zmienione pola należą już do obszaru o nowym korzeniu, więc nie trzeba
+    // ich oznaczać jako odwiedzone.
     while (!queue_empty(q))
     {
-        coords_t coords = queue_get(q);
-        uint32_t x = coords.x;
-        uint32_t y = coords.y;
-        if (x > 0 && check_if_same_player(g, player, x - 1, y))
-        {
-            (*(g->board))[x - 1][y].visited = true;
-            (*(g->board))[x - 1][y].area = new_area_number;
-            queue_insert_field(q, x - 1, y);
-        }
-        if (x < g->max_width - 1 && check_if_same_player(g, player, x + 1, y))
+        uint64_t index = queue_get(q);
+        for (uint32_t direction = 0; direction < 4; direction++)
         {
-            (*(g->board))[x + 1][y].visited = true;
-            (*(g->board))[x + 1][y].area = new_area_number;
-            queue_insert_field(q, x + 1, y);
-        }
-        if (y > 0 && check_if_same_player(g, player, x, y - 1))
-        {
-            (*(g->board))[x][y - 1].visited = true;
-            (*(g->board))[x][y - 1].area = new_area_number;
-            queue_insert_field(q, x, y - 1);
-        }
-        if (y < g->max_height - 1 && check_if_same_player(g, player, x, y + 1))
-        {
-            (*(g->board))[x][y + 1].visited = true;
-            (*(g->board))[x][y + 1].area = new_area_number;
-            queue_insert_field(q, x, y + 1);
+            uint64_t next;
+            if (neighbour_index(g, index, direction, &next) && owner_at(g, next) == player
+                && area_root(g, player, area_at(g, next)) == old_area_number)
+                relabel_field(g, player, next, new_area_number);
         }
     }
-    free(q);
-    reset_visited(g, coordinates);
 }
 
-/** @brief Resetuje informacje o obszarze sąsiadów podanego pola
- * Sprawdza czy sąsiad podanego pola należy do gracza i czy nie ma numeru nowego obszaru.
- * Jeśli tak to zeruje obie wartości.
- * @param[in, out] g   – struktura przechowująca stan gry,
- * @param[in] player   – indeks gracza,
- * @param[in] x   – współrzędna x pola,
- * @param[in] y   – współrzędna y pola,
- * @param[in] new_area_number  – indeks nowego obszaru,
+/** @brief Znajduje przejście reprezentujące grupę połączonych przejść
+ * @param[in] group   – dla każdego przejścia przejście, z którym je połączono, lub ono samo,
+ * @param[in] search   – numer przejścia,
+ * @return Numer przejścia reprezentującego grupę.
  */
 
-static void reset_area_info(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, uint32_t new_area_number)
+static uint32_t group_of(const uint32_t *group, uint32_t search)
 {
-    if (x > 0 && ((*(g->board))[x - 1][y]).owner == player
-        && g->player_info[player].area_number[((*(g->board))[x - 1][y]).area] != new_area_number)
-    {
-        g->player_info[player].area_size[((*(g->board))[x - 1][y]).area] = 0;
-        g->player_info[player].area_number[((*(g->board))[x - 1][y]).area] = 0;
-    }
-    if (x < g->max_width - 1 && ((*(g->board))[x + 1][y]).owner == player
-        && g->player_info[player].area_number[((*(g->board))[x + 1][y]).area] != new_area_number)
-    {
-        g->player_info[player].area_size[((*(g->board))[x + 1][y]).area] = 0;
-        g->player_info[player].area_number[((*(g->board))[x + 1][y]).area] = 0;
-    }
-    if (y > 0 && ((*(g->board))[x][y - 1]).owner == player
-        && g->player_info[player].area_number[((*(g->board))[x][y - 1]).area] != new_area_number)
-    {
-        g->player_info[player].area_size[((*(g->board))[x][y - 1]).area] = 0;
-        g->player_info[player].area_number[((*(g->board))[x][y - 1]).area] = 0;
-    }
-    if (x < g->max_width - 1 && ((*(g->board))[x + 1][y]).owner == player
-        && g->player_info[player].area_number[((*(g->board))[x + 1][y]).area] != new_area_number)
-    {
-        g->player_info[player].area_size[((*(g->board))[x + 1][y]).area] = 0;
-        g->player_info[player].area_number[((*(g->board))[x + 1][y]).area] = 0;
-    }
+    while (group[search] != search)
+        search = group[search];
+    return search;
 }
 
-/** @brief Aktualizuje numer obszaru z jednej podanej strony
- * Sprawdza kierunek przez podany znak i ustawia numery obszarów z innych stron
- * na ten sam.
+/** @brief Wykonuje jeden krok grupy przejść rozbijanego obszaru
+ * Pobiera pole z kolejki któregoś przejścia grupy i odwiedza jego
+ * nieodwiedzonych sąsiadów należących do gracza. Sąsiad odwiedzony przez
+ * inną grupę oznacza, że obie grupy przechodzą tę samą część obszaru,
+ * więc zostają połączone.
  * @param[in, out] g   – struktura przechowująca stan gry,
  * @param[in] player   – indeks gracza,
- * @param[in] x   – współrzędna x pola,
- * @param[in] y   – współrzędna y pola,
- * @param[in] new_area_size  – rozmiar nowego obszaru,
- * @param[in] direction  – kierunek,
+ * @param[in] removed   – indeks zabieranego pola,
+ * @param[in] first   – numer pierwszego z przejść,
+ * @param[in] count   – liczba przejść,
+ * @param[in] rep   – przejście reprezentujące grupę,
+ * @param[in, out] group   – połączenia przejść (zob. @ref group_of),
+ * @param[in, out] sizes   – liczby pól odwiedzonych przez grupy,
+ * @param[in, out] live   – liczba niezakończonych grup,
+ * @return Zwraca false jeśli kolejki wszystkich przejść grupy są puste,
+ * a true w przeciwnym wypadku.
  */
 
-static void update_one_direction(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, uint32_t new_area_size, char direction)
+static bool split_step(gamma_t *g, uint32_t player, uint64_t removed, uint32_t first, uint32_t count,
+                       uint32_t rep, uint32_t *group, uint64_t *sizes, uint32_t *live)
 {
-    coords_t *coords = malloc(sizeof(coords_t));
-    checkNull(coords);
-
-    uint32_t directed_x = 0, directed_y = 0;
-    switch(direction)
+    uint32_t search = 0;
+    while (search < count && (group_of(group, search) != rep || queue_empty(&g->queues[search])))
+        search++;
+    if (search == count)
+        return false;
+
+    uint64_t index = queue_get(&g->queues[search]);
+    for (uint32_t direction = 0; direction < 4; direction++)
     {
-        case 'u':
-            directed_x = x;
-            directed_y = y + 1;
-            break;
-        case 'l':
-            directed_x = x - 1;
-            directed_y = y;
-            break;
-        case 'r':
-            directed_x = x + 1;
-            directed_y = y;
-            break;
-        case 'd':
-            directed_x = x;
-            directed_y = y - 1;
-            break;
+        uint64_t next;
+        if (!neighbour_index(g, index, direction, &next) || next == removed
+            || owner_at(g, next) != player)
+            continue;
+
+        uint32_t *visit = visit_at(g, next);
+        uint32_t visitor = *visit - first;
+        if (visitor >= count)
+        {
+            *visit = first + search;
+            queue_insert(&g->queues[search], next);
+            (sizes[rep])++;
+        }
+        else if (group_of(group, visitor) != rep)
+        {
+            uint32_t other = group_of(group, visitor);
+            group[other] = rep;
+            sizes[rep] += sizes[other];
+            sizes[other] = 0;
+            (*live)--;
+        }
     }
-
-    uint32_t new_area_number = g->player_info[player].area_number[((*(g->board))[directed_x][directed_y]).area];
-
-    reset_area_info(g, player, x, y, new_area_number);
-
-    g->player_info[player].area_number[((*(g->board))[directed_x][directed_y]).area] = new_area_number;
-
-    coords->x = x - 1;
-    coords->y = y;
-    set_new_area_number(g, *coords, player, ((*(g->board))[directed_x][directed_y]).area);
-
-    coords->x = x + 1;
-    coords->y = y;
-    set_new_area_number(g, *coords, player, ((*(g->board))[directed_x][directed_y]).area);
-
-    coords->x = x;
-    coords->y = y - 1;
-    set_new_area_number(g, *coords, player, ((*(g->board))[directed_x][directed_y]).area);
-
-    coords->x = x;
-    coords->y = y + 1;
-    set_new_area_number(g, *coords, player, ((*(g->board))[directed_x][directed_y]).area);
-
-    g->player_info[player].area_size[((*(g->board))[directed_x][directed_y]).area] = new_area_size;
-    ((*(g->board))[x][y]).area = ((*(g->board))[directed_x][directed_y]).area;
-
-    free(coords);
+    return true;
 }
 
-void gamma_update_area(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, bool add)
+void split_area(gamma_t *g, uint32_t player, uint64_t removed, const uint64_t *starts, uint32_t count,
+                uint64_t *sizes)
 {
-    uint32_t left = 0, up = 0, right = 0, down = 0;
-    if (x > 0 && ((*(g->board))[x - 1][y]).owner == player)
-        left = g->player_info[player].area_size[((*(g->board))[x - 1][y]).area];
-
-    if (y < g->max_height - 1 && ((*(g->board))[x][y + 1]).owner == player)
-        up = g->player_info[player].area_size[((*(g->board))[x][y + 1]).area];
-
-    if (x < g->max_width - 1 && ((*(g->board))[x + 1][y]).owner == player)
-        right = g->player_info[player].area_size[((*(g->board))[x + 1][y]).area];
-
-    if (y > 0 && ((*(g->board))[x][y - 1]).owner == player)
-        down = g->player_info[player].area_size[((*(g->board))[x][y - 1]).area];
-
-    uint32_t max_area = max(max(left, up), max(right, down));
-
-    uint32_t new_area_size = left + up + right + down + 1;
-
-    uint32_t areas = count_areas(g, player, x, y);
-
-    if (add)
-        (g->player_info[player].current_areas) += areas - 1;
-    else
-        (g->player_info[player].current_areas) -= areas - 1;
-
-
-    if (max_area == up)
-    {
-       update_one_direction(g, player, x, y, new_area_size, 'u');
-    }
-    else if (max_area == left)
-    {
-        update_one_direction(g, player, x, y, new_area_size, 'l');
-    }
-    else if (max_area == right)
+    uint32_t group[4];
+    bool finished[4];
+    uint32_t first = new_visits(g, count);
+    for (uint32_t i = 0; i < count; i++)
     {
-        update_one_direction(g, player, x, y, new_area_size, 'r');
-    }
-    else if (max_area == down)
-    {
-        update_one_direction(g, player, x, y, new_area_size, 'd');
+        group[i] = i;
+        finished[i] = false;
+        sizes[i] = 1;
+        *visit_at(g, starts[i]) = first + i;
+        queue_initialize(&g->queues[i]);
+        queue_insert(&g->queues[i], starts[i]);
     }
+
+    // Grupy wykonują kroki na zmianę, więc największa część jest przeglądana
+    // najwyżej tyle kroków, ile pól liczy największa z pozostałych części.
+    uint32_t live = count;
+    while (live > 1)
+        for (uint32_t i = 0; i < count && live > 1; i++)
+        {
+            if (group[i] != i || finished[i])
+                continue;
+            if (!split_step(g, player, removed, first, count, i, group, sizes, &live))
+            {
+                finished[i] = true;
+                live--;
+            }
+        }
+
+    for (uint32_t i = 0; i < count; i++)
+        if (group[i] != i || !finished[i])
+            sizes[i] = 0;
 }
@@ -13,54 +13,47 @@
 #include "gamma.h"
 #include "gamma_t.h"
 
-/**
-  * Struktura przechowująca współrzędne pola.
-  */
-
-typedef struct coordinates
-{
-    uint32_t x; ///< Współrzędna x
-    uint32_t y; ///< Współrzędna y
-}coords_t;
-
-/** @brief Zlicza liczbę różnych obszarów sąsiadujących z podanym polem.
- * Najpierw sprawdza czy sąsiedzi należą do tego samego gracza.
- * Jeśli tak, zapisuje indeksy ich obszarów do tablicy.
- * Następnie zlicza ilość różnych niezerowych indeksów obszarów.
+/** @brief Liczy na ile części rozpadnie się obszar po zabraniu każdego z jego pól
+ * Przechodzi obszar iteracyjnym dfsem i wyznacza punkty artykulacji
+ * algorytmem Tarjana. Wynik każdego pola (0 dla obszaru złożonego z jednego
+ * pola) zapisuje w jego wartości pieces (zob. @ref area_set_pieces).
  * @param[in, out] g   – struktura przechowująca stan gry,
  * @param[in] player   – indeks gracza,
- * @param[in] x   – współrzędna x pola,
- * @param[in] y   – współrzędna y pola,
- * @return Zwraca liczbę różnych obszarów sąsiadujących z podanym polem.
+ * @param[in] root   – indeks dowolnego pola obszaru,
+ * @param[in] size   – liczba pól obszaru, mniejsza niż 2^32,
  */
 
-uint32_t count_areas(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+void count_area_pieces(gamma_t *g, uint32_t player, uint64_t root, uint64_t size);
 
-/** @brief Sprawdza czy jest możliwe przejście między dwoma polami w tym samym obszarze za pomocą bfsa
+/** @brief Zmienia numer obszaru wszystkim polom spójnej części
+ * Przechodzi bfsem po polach gracza z obszaru o korzeniu @p old_area_number
+ * zaczynając od pola @p start i nadaje im numer @p new_area_number. Zmiany są
+ * zapisywane w dzienniku.
  * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] start   – indeks pierwszego pola części,
  * @param[in] player   – indeks gracza,
- * @param[in] begin   – współrzędne początku,
- * @param[in] end   – współrzędne końca,
- * @param[in] area_number  – indeks obszaru po którym będzie przechodzić,
- * @return Zwraca true jeśli udało się przejść pomiędzy tymi polami w jednym obszarze,
- * false w przeciwnym wypadku.
+ * @param[in] old_area_number  – korzeń dotychczasowego obszaru pól części,
+ * @param[in] new_area_number  – korzeń nowego obszaru, różny od @p old_area_number,
  */
 
-bool bfs(gamma_t *g, uint32_t player, coords_t begin, coords_t end, uint32_t area_number);
+void relabel_area(gamma_t *g, uint64_t start, uint32_t player, uint32_t old_area_number, uint32_t new_area_number);
 
-/** @brief Aktualizuje indeksy obszaru w przypadku złączania obszarów
- * Najpierw sprawdza który z sąsiednich obszarów jest największy by
- * później przechodzić bfsem po pozostałych, na pewno mniejszych lub równych
- * obszarach i aktualizować ich indeks obszaru na indeks obszaru największego
- * obszaru.
+/** @brief Znajduje mniejsze części rozbitego obszaru
+ * Zaczyna przejście bfsem z każdego z pól @p starts i wykonuje kroki
+ * przejść na zmianę. Przejścia, które się spotkają, przechodzą tę samą
+ * część i zostają połączone. Kończy, gdy została najwyżej jedna
+ * niezakończona grupa przejść, więc największej części nie przegląda do końca.
+ * Zabierane pole jest pomijane, więc może jeszcze należeć do gracza.
  * @param[in, out] g   – struktura przechowująca stan gry,
  * @param[in] player   – indeks gracza,
- * @param[in] x  – współrzędna x pola,
- * @param[in] y  – współrzędna y pola,
- * @param[in] add  – flaga informująca czy zwiększać czy zmniejszać liczbę obszarów
- * należących do danego gracza.
+ * @param[in] removed   – indeks zabieranego pola,
+ * @param[in] starts   – indeksy pól gracza, które sąsiadowały z zabranym polem,
+ * @param[in] count   – liczba pól w @p starts, od 1 do 4,
+ * @param[out] sizes   – dla jednego pola z każdej części przejrzanej w całości
+ * rozmiar tej części, a dla pozostałych pól z @p starts 0,
  */
 
-void gamma_update_area(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, bool add);
+void split_area(gamma_t *g, uint32_t player, uint64_t removed, const uint64_t *starts, uint32_t count,
+                uint64_t *sizes);
 
 #endif //GAMMA_BFS_H
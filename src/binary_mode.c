@@ -0,0 +1,62 @@
+/** @file
+ * Implementacja klasy obsługującej binarny tryb wsadowy
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 18.06.2020
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "binary_mode.h"
+#include "batch_mode.h"
+#include "input.h"
+#include "output.h"
+#include "gamma_t.h"
+#include "render.h"
+
+/** @brief Zapisuje opis planszy poprzedzony jego długością
+ * Długość jest obliczana bez tworzenia opisu, więc plansza jest opisywana
+ * tylko raz.
+ * @param[in] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] output   – struktura buforująca wyjście,
+ */
+
+static void write_board(gamma_t *g, output_t *output)
+{
+    uint64_t length = render_length(g);
+
+    output_bytes(output, &length, sizeof(length));
+    output_flush(output);
+    gamma_board_print(g, stdout);
+    fflush(stdout);
+}
+
+void binary_mode(gamma_t *g)
+{
+    line_reader_t reader;
+    output_t output;
+    const char *record;
+
+    reader_open(&reader, stdin);
+    output_open(&output);
+    while (reader_next_block(&reader, sizeof(binary_command_t), &record))
+    {
+        binary_command_t command;
+        memcpy(&command, record, sizeof(command));
+
+        if (command.opcode == 'p')
+        {
+            write_board(g, &output);
+            continue;
+        }
+
+        uint32_t parameters[3] = {command.player, command.x, command.y};
+        uint64_t result = BINARY_ERROR;
+        if (command.opcode > UINT8_MAX || !batch_execute(g, (char) command.opcode, parameters, &result))
+            result = BINARY_ERROR;
+        output_bytes(&output, &result, sizeof(result));
+    }
+    output_close(&output);
+    reader_close(&reader);
+}
@@ -0,0 +1,48 @@
+/** @file
+ * Interfejs klasy obsługującej binarny tryb wsadowy
+ *
+ * Po wierszu nagłówka "R szerokość wysokość gracze obszary" i odpowiedzi
+ * "OK numer_wiersza" wejście składa się z rekordów @ref binary_command_t,
+ * a wyjście z wyników zapisanych jako liczby typu uint64_t. Liczby są
+ * zapisane w kolejności bajtów komputera, na którym działa program.
+ *
+ * Komenda p zapisuje długość opisu planszy jako liczbę uint64_t,
+ * a po niej opis planszy bez kończącego znaku '\0'. Dla niepoprawnej
+ * komendy zapisywana jest wartość @ref BINARY_ERROR. Niepełny rekord
+ * na końcu wejścia jest pomijany.
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 18.06.2020
+ */
+
+#ifndef GAMMA_BINARY_MODE_H
+#define GAMMA_BINARY_MODE_H
+#include <inttypes.h>
+#include "gamma.h"
+
+/**
+ * Wynik zapisywany dla niepoprawnej komendy.
+ */
+#define BINARY_ERROR UINT64_MAX
+
+/**
+ * Rekord opisujący jedną komendę trybu binarnego.
+ */
+
+typedef struct binary_command
+{
+    uint32_t opcode; ///< litera komendy (m, g, b, f, q lub p)
+    uint32_t player; ///< numer gracza
+    uint32_t x; ///< numer kolumny
+    uint32_t y; ///< numer wiersza
+} binary_command_t;
+
+/** @brief Główna funkcja obsługująca binarny tryb wsadowy
+ * Funkcja wykonuje kolejne rekordy z wejścia aż do jego końca.
+ * @param[in, out] g   – wskaźnik na strukturę przechowującą stan gry,
+ */
+
+void binary_mode(gamma_t *g);
+
+#endif //GAMMA_BINARY_MODE_H
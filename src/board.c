@@ -0,0 +1,340 @@
+/** @file
+ * Implementacja klasy przechowującej pola planszy
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 29.05.2020
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "board.h"
+
+/** Liczba pól we fragmencie rzadkiej planszy */
+#define TILE_FIELDS (TILE_SIDE * TILE_SIDE)
+
+/** Początkowy rozmiar tablicy haszującej fragmentów */
+#define INITIAL_TILES_CAPACITY 16
+
+tile_storage_t *tile_storage(const tile_t *tile)
+{
+    return (tile_storage_t *) ((char *) tile->areas - offsetof(tile_storage_t, areas));
+}
+
+uint32_t tile_fields(const gamma_t *g, const tile_t *tile)
+{
+    if (g->blocks == NULL)
+        return TILE_FIELDS;
+
+    uint64_t first = (uint64_t) (tile - g->blocks) << BLOCK_SHIFT;
+    uint64_t fields = (uint64_t) g->max_width * g->max_height;
+    return fields - first < BLOCK_FIELDS ? (uint32_t) (fields - first) : BLOCK_FIELDS;
+}
+
+size_t tile_storage_size(const gamma_t *g, uint32_t fields)
+{
+    return sizeof(tile_storage_t) + (size_t) fields * field_bytes(g->owner_bytes);
+}
+
+void tile_attach(const gamma_t *g, tile_t *tile, tile_storage_t *storage, uint32_t fields)
+{
+    tile->areas = storage->areas;
+    tile->owners = storage->areas + fields;
+    tile->neighbours = (uint8_t *) tile->owners + (size_t) fields * g->owner_bytes;
+}
+
+/** @brief Przydziela fragmentowi pamięć z wolnymi polami
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[out] tile   – fragment,
+ * @param[in] fields   – liczba pól fragmentu,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+static bool allocate_tile(const gamma_t *g, tile_t *tile, uint32_t fields)
+{
+    // calloc zeruje numery obszarów, właścicieli i sąsiadów.
+    tile_storage_t *storage = calloc(1, tile_storage_size(g, fields));
+    if (!storage)
+        return false;
+
+    atomic_init(&storage->references, 1);
+    tile_attach(g, tile, storage, fields);
+    tile->visits = NULL;
+    tile->pieces = NULL;
+    tile->shared = false;
+    return true;
+}
+
+/** @brief Oddaje pamięć fragmentu
+ * Zwalnia ją, jeśli nie korzysta z niej już żadna inna gra.
+ * @param[in, out] tile   – fragment, może być pustym wpisem,
+ */
+
+static void release_tile(tile_t *tile)
+{
+    if (tile->areas == NULL)
+        return;
+
+    free(tile->visits);
+    tile->visits = NULL;
+    tile->pieces = NULL;
+    tile_storage_t *storage = tile_storage(tile);
+    if (!tile->shared || atomic_fetch_sub_explicit(&storage->references, 1, memory_order_acq_rel) == 1)
+        free(storage);
+    tile->areas = NULL;
+    tile->owners = NULL;
+    tile->neighbours = NULL;
+}
+
+void tile_unshare(const gamma_t *g, tile_t *tile)
+{
+    tile_storage_t *storage = tile_storage(tile);
+    // Gra, która jako jedyna korzysta z pamięci, może ją zmieniać bez kopiowania.
+    if (atomic_load_explicit(&storage->references, memory_order_acquire) != 1)
+    {
+        uint32_t fields = tile_fields(g, tile);
+        tile_storage_t *copy = malloc(tile_storage_size(g, fields));
+        checkNull(copy);
+        atomic_init(&copy->references, 1);
+        memcpy(copy->areas, storage->areas, tile_storage_size(g, fields) - sizeof(tile_storage_t));
+        tile_attach(g, tile, copy, fields);
+        if (atomic_fetch_sub_explicit(&storage->references, 1, memory_order_acq_rel) == 1)
+            free(storage);
+    }
+    tile->shared = false;
+}
+
+void tile_visits(const gamma_t *g, tile_t *tile)
+{
+    uint32_t fields = tile_fields(g, tile);
+    tile->visits = calloc(fields, sizeof *(tile->visits) + sizeof *(tile->pieces));
+    checkNull(tile->visits);
+    tile->pieces = (uint8_t *) (tile->visits + fields);
+}
+
+/** @brief Zaczyna współdzielić pamięć fragmentu z kopią gry
+ * @param[in, out] tile   – fragment gry, może być pustym wpisem,
+ * @param[out] copy   – odpowiadający mu fragment kopii gry,
+ */
+
+static void share_tile(tile_t *tile, tile_t *copy)
+{
+    *copy = *tile;
+    copy->visits = NULL;
+    copy->pieces = NULL;
+    if (tile->areas == NULL)
+        return;
+
+    atomic_fetch_add_explicit(&tile_storage(tile)->references, 1, memory_order_relaxed);
+    tile->shared = true;
+    copy->shared = true;
+}
+
+/** @brief Wylicza numer fragmentu, w którym leży pole
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @return Numer fragmentu.
+ */
+
+static uint64_t tile_key(uint32_t x, uint32_t y)
+{
+    return (uint64_t) (y >> TILE_SHIFT) << 32 | (x >> TILE_SHIFT);
+}
+
+/** @brief Wylicza pozycję w tablicy haszującej, od której zaczyna się szukanie fragmentu
+ * @param[in] key   – numer fragmentu,
+ * @param[in] capacity   – rozmiar tablicy haszującej, potęga dwójki,
+ * @return Pozycja w tablicy haszującej.
+ */
+
+static uint64_t tile_hash(uint64_t key, uint64_t capacity)
+{
+    uint64_t hash = key * 0x9E3779B97F4A7C15u;
+    return (hash ^ (hash >> 32)) & (capacity - 1);
+}
+
+/** @brief Znajduje wpis fragmentu w tablicy haszującej
+ * @param[in] tiles   – tablica haszująca,
+ * @param[in] capacity   – rozmiar tablicy haszującej,
+ * @param[in] key   – numer fragmentu,
+ * @return Wskaźnik na wpis fragmentu lub na pusty wpis, w którym powinien się znaleźć.
+ */
+
+static tile_t *find_tile(tile_t *tiles, uint64_t capacity, uint64_t key)
+{
+    uint64_t i = tile_hash(key, capacity);
+    while (tiles[i].areas != NULL && tiles[i].key != key)
+        i = (i + 1) & (capacity - 1);
+    return &tiles[i];
+}
+
+tile_t *sparse_tile(const gamma_t *g, uint32_t x, uint32_t y)
+{
+    tile_t *tile = find_tile(g->tiles, g->tiles_capacity, tile_key(x, y));
+    return tile->areas != NULL ? tile : NULL;
+}
+
+/** @brief Powiększa dwukrotnie tablicę haszującą fragmentów
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+static bool grow_tiles(gamma_t *g)
+{
+    uint64_t capacity = 2 * g->tiles_capacity;
+    tile_t *tiles = calloc(capacity, sizeof *tiles);
+    if (!tiles)
+        return false;
+
+    for (uint64_t i = 0; i < g->tiles_capacity; i++)
+        if (g->tiles[i].areas != NULL)
+            *find_tile(tiles, capacity, g->tiles[i].key) = g->tiles[i];
+
+    free(g->tiles);
+    g->tiles = tiles;
+    g->tiles_capacity = capacity;
+    return true;
+}
+
+/** @brief Zakłada fragment zawierający pole, jeśli jeszcze nie istnieje
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @return Zwraca true jeśli fragment istnieje, false gdy zabrakło pamięci.
+ */
+
+static bool materialize_tile(gamma_t *g, uint32_t x, uint32_t y)
+{
+    uint64_t key = tile_key(x, y);
+    if (find_tile(g->tiles, g->tiles_capacity, key)->areas != NULL)
+        return true;
+
+    // Tablica jest zapełniona co najwyżej w połowie, żeby szukanie było krótkie.
+    if (2 * (g->tiles_count + 1) > g->tiles_capacity && !grow_tiles(g))
+        return false;
+
+    tile_t *tile = find_tile(g->tiles, g->tiles_capacity, key);
+    if (!allocate_tile(g, tile, TILE_FIELDS))
+        return false;
+    tile->key = key;
+    (g->tiles_count)++;
+    return true;
+}
+
+bool board_new(gamma_t *g)
+{
+    uint64_t fields = (uint64_t) g->max_width * g->max_height;
+    g->blocks = NULL;
+    g->blocks_count = 0;
+    g->tiles = NULL;
+    g->tiles_count = 0;
+    g->tiles_capacity = 0;
+
+    // Numer właściciela zajmuje tylko tyle bajtów, ile wymaga liczba graczy.
+    if (g->players <= UINT8_MAX)
+        g->owner_bytes = 1;
+    else if (g->players <= UINT16_MAX)
+        g->owner_bytes = 2;
+    else
+        g->owner_bytes = 4;
+
+    if (board_dense(fields, g->owner_bytes))
+    {
+        // Wszystkie bloki współdzielą na początku jeden wolny blok, więc pamięć
+        // bloku jest przydzielana dopiero przy pierwszym użyciu jego pól.
+        tile_t empty;
+        uint64_t count = (fields + BLOCK_FIELDS - 1) >> BLOCK_SHIFT;
+        g->blocks = malloc(count * sizeof *(g->blocks));
+        if (!g->blocks || !allocate_tile(g, &empty, fields < BLOCK_FIELDS ? fields : BLOCK_FIELDS))
+        {
+            free(g->blocks);
+            g->blocks = NULL;
+            return false;
+        }
+
+        atomic_store_explicit(&tile_storage(&empty)->references, count, memory_order_relaxed);
+        g->blocks_count = count;
+        for (uint64_t i = 0; i < count; i++)
+        {
+            g->blocks[i] = empty;
+            tile_attach(g, &g->blocks[i], tile_storage(&empty), tile_fields(g, &g->blocks[i]));
+            g->blocks[i].shared = true;
+        }
+        return true;
+    }
+
+    g->tiles = calloc(INITIAL_TILES_CAPACITY, sizeof *(g->tiles));
+    if (!g->tiles)
+        return false;
+    g->tiles_capacity = INITIAL_TILES_CAPACITY;
+    return true;
+}
+
+void board_delete(gamma_t *g)
+{
+    for (uint64_t i = 0; i < g->blocks_count; i++)
+        release_tile(&g->blocks[i]);
+    for (uint64_t i = 0; i < g->tiles_capacity; i++)
+        release_tile(&g->tiles[i]);
+    free(g->blocks);
+    free(g->tiles);
+    g->blocks = NULL;
+    g->blocks_count = 0;
+    g->tiles = NULL;
+    g->tiles_capacity = 0;
+}
+
+bool board_clone(gamma_t *g, gamma_t *copy)
+{
+    copy->owner_bytes = g->owner_bytes;
+    copy->blocks = NULL;
+    copy->blocks_count = 0;
+    copy->tiles = NULL;
+    copy->tiles_count = 0;
+    copy->tiles_capacity = 0;
+
+    if (g->blocks != NULL)
+    {
+        copy->blocks = malloc(g->blocks_count * sizeof *(copy->blocks));
+        if (!copy->blocks)
+            return false;
+        for (uint64_t i = 0; i < g->blocks_count; i++)
+            share_tile(&g->blocks[i], &copy->blocks[i]);
+        copy->blocks_count = g->blocks_count;
+        return true;
+    }
+
+    copy->tiles = malloc(g->tiles_capacity * sizeof *(copy->tiles));
+    if (!copy->tiles)
+        return false;
+    for (uint64_t i = 0; i < g->tiles_capacity; i++)
+        share_tile(&g->tiles[i], &copy->tiles[i]);
+    copy->tiles_count = g->tiles_count;
+    copy->tiles_capacity = g->tiles_capacity;
+    return true;
+}
+
+bool board_materialize(gamma_t *g, uint32_t x, uint32_t y)
+{
+    if (g->blocks != NULL)
+        return true;
+
+    return materialize_tile(g, x, y)
+           && (x == 0 || materialize_tile(g, x - 1, y))
+           && (y == 0 || materialize_tile(g, x, y - 1))
+           && (x == g->max_width - 1 || materialize_tile(g, x + 1, y))
+           && (y == g->max_height - 1 || materialize_tile(g, x, y + 1));
+}
+
+void board_clear_visits(gamma_t *g)
+{
+    for (uint64_t i = 0; i < g->blocks_count; i++)
+        if (g->blocks[i].visits != NULL)
+            memset(g->blocks[i].visits, 0, tile_fields(g, &g->blocks[i]) * sizeof *(g->blocks[i].visits));
+
+    for (uint64_t i = 0; i < g->tiles_capacity; i++)
+        if (g->tiles[i].areas != NULL && g->tiles[i].visits != NULL)
+            memset(g->tiles[i].visits, 0, TILE_FIELDS * sizeof *(g->tiles[i].visits));
+}
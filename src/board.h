@@ -0,0 +1,139 @@
+/** @file
+ * Interfejs klasy przechowującej pola planszy
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 29.05.2020
+ */
+
+#ifndef GAMMA_BOARD_H
+#define GAMMA_BOARD_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include "gamma.h"
+#include "gamma_t.h"
+
+/**
+  * Największy rozmiar w bajtach pól i właścicieli planszy przechowywanej
+  * blokami w jednej ciągłej tablicy. Większe plansze są przechowywane rzadko,
+  * fragmentami zakładanymi przy pierwszym zapisie.
+  */
+
+#define DENSE_BOARD_BYTES ((uint64_t) 4 << 30)
+
+/**
+  * Pamięć fragmentu planszy: licznik gier, które ją współdzielą, numery
+  * obszarów pól fragmentu, a za nimi właściciele i zajęci sąsiedzi pól.
+  */
+
+typedef struct tile_storage
+{
+    atomic_uint references; ///< liczba gier korzystających z tej pamięci
+    uint32_t areas[]; ///< numery obszarów pól fragmentu
+} tile_storage_t;
+
+/** @brief Podaje rozmiar informacji o jednym polu w pamięci fragmentu
+ * @param[in] owner_bytes   – rozmiar numeru właściciela w bajtach,
+ * @return Liczba bajtów numeru obszaru, właściciela i zajętych sąsiadów pola.
+ */
+
+static inline size_t field_bytes(uint32_t owner_bytes)
+{
+    return sizeof(uint32_t) + owner_bytes + sizeof(uint8_t);
+}
+
+/** @brief Znajduje pamięć, w której leżą pola fragmentu
+ * @param[in] tile   – założony fragment,
+ * @return Wskaźnik na pamięć fragmentu.
+ */
+
+tile_storage_t *tile_storage(const tile_t *tile);
+
+/** @brief Podaje liczbę pól fragmentu
+ * Fragmenty rzadkiej planszy są pełne, a ostatni blok ciągłej planszy może być krótszy.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] tile   – fragment rzadkiej planszy lub blok ciągłej planszy gry @p g,
+ * @return Liczba pól fragmentu.
+ */
+
+uint32_t tile_fields(const gamma_t *g, const tile_t *tile);
+
+/** @brief Podaje rozmiar pamięci fragmentu o podanej liczbie pól
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] fields   – liczba pól fragmentu,
+ * @return Rozmiar pamięci w bajtach.
+ */
+
+size_t tile_storage_size(const gamma_t *g, uint32_t fields);
+
+/** @brief Ustawia tablice fragmentu na pamięć o podanej liczbie pól
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[out] tile   – fragment,
+ * @param[in] storage   – pamięć fragmentu,
+ * @param[in] fields   – liczba pól fragmentu,
+ */
+
+void tile_attach(const gamma_t *g, tile_t *tile, tile_storage_t *storage, uint32_t fields);
+
+/** @brief Sprawdza czy plansza jest przechowywana blokami w ciągłej tablicy
+ * Decyduje rozmiar pamięci, którą zajęłyby wszystkie bloki planszy,
+ * a nie sama liczba pól, więc próg przesuwa się razem z rozmiarem pola.
+ * @param[in] fields   – liczba pól planszy,
+ * @param[in] owner_bytes   – rozmiar numeru właściciela w bajtach,
+ * @return Zwraca true jeśli pamięć pól i właścicieli nie przekracza
+ * @ref DENSE_BOARD_BYTES, false w przeciwnym wypadku.
+ */
+
+static inline bool board_dense(uint64_t fields, uint32_t owner_bytes)
+{
+    return fields <= DENSE_BOARD_BYTES / field_bytes(owner_bytes);
+}
+
+/** @brief Tworzy pustą planszę
+ * Plansze spełniające @ref board_dense alokuje w całości,
+ * blokami po @ref BLOCK_FIELDS kolejnych pól, dla większych tworzy tylko
+ * pustą tablicę haszującą fragmentów.
+ * Rozmiar numeru właściciela dobiera do liczby graczy.
+ * @param[in, out] g   – struktura przechowująca stan gry z ustawionymi wymiarami planszy i liczbą graczy,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+bool board_new(gamma_t *g);
+
+/** @brief Zwalnia pamięć zajmowaną przez planszę
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ */
+
+void board_delete(gamma_t *g);
+
+/** @brief Tworzy planszę kopii gry współdzielącą pamięć fragmentów z planszą gry
+ * Kopiuje tylko tablicę fragmentów, bez numerów przejść i liczb części pól. Pamięć fragmentu jest kopiowana dopiero
+ * wtedy, gdy któraś z gier zacznie korzystać z jego pól (zob. @ref own_tile).
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[out] copy   – struktura kopii gry z ustawionymi wymiarami planszy i liczbą graczy,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+bool board_clone(gamma_t *g, gamma_t *copy);
+
+/** @brief Zakłada pole i jego sąsiadów na rzadkiej planszy
+ * Musi zostać wywołana przed zajęciem pola (@p x, @p y), dzięki czemu
+ * zajęte pola i ich sąsiedzi są zawsze dostępne przez @ref tile_at.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+bool board_materialize(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Zeruje numery przejść we wszystkich założonych polach planszy
+ * Zmienia tylko istniejące tablice visits gry, więc nie kopiuje
+ * współdzielonych fragmentów.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ */
+
+void board_clear_visits(gamma_t *g);
+
+#endif //GAMMA_BOARD_H
@@ -0,0 +1,225 @@
+/** @file
+ * Implementacja klasy przechowującej pola sąsiadujące z obszarami graczy
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 26.05.2020
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "frontier.h"
+#include "journal.h"
+#include "player.h"
+#include "positions.h"
+
+/** @brief Zwraca indeks sąsiada pola w podanym kierunku
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks pola,
+ * @param[in] direction   – kierunek, w którym pole ma sąsiada (0 – lewo, 1 – prawo, 2 – dół, 3 – góra),
+ * @return Indeks sąsiada.
+ */
+
+static uint64_t neighbour_at(const gamma_t *g, uint64_t index, uint32_t direction)
+{
+    switch (direction)
+    {
+        case 0:
+            return index - 1;
+        case 1:
+            return index + 1;
+        case 2:
+            return index - g->max_width;
+        default:
+            return index + g->max_width;
+    }
+}
+
+/** @brief Wyznacza różnych graczy posiadających pola sąsiadujące z polem
+ * Czyta właścicieli tylko tych sąsiadów, których bity są ustawione
+ * w masce zajętych sąsiadów pola.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks pola,
+ * @param[out] players   – tablica na co najwyżej czterech graczy,
+ * @return Liczba różnych graczy.
+ */
+
+static uint32_t neighbour_players(const gamma_t *g, uint64_t index, uint32_t *players)
+{
+    uint8_t neighbours = neighbours_at(g, index);
+    uint32_t count = 0;
+    for (uint32_t direction = 0; direction < 4; direction++)
+    {
+        if (!(neighbours & (1u << direction)))
+            continue;
+        uint32_t owner = owner_at(g, neighbour_at(g, index, direction));
+        uint32_t i = 0;
+        while (i < count && players[i] != owner)
+            i++;
+        if (i == count)
+            players[count++] = owner;
+    }
+    return count;
+}
+
+/** @brief Liczy sąsiednie pola gracza
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks pola,
+ * @param[in] player   – indeks gracza,
+ * @return Liczba pól gracza sąsiadujących z polem.
+ */
+
+static uint32_t count_neighbours(const gamma_t *g, uint64_t index, uint32_t player)
+{
+    uint8_t neighbours = neighbours_at(g, index);
+    uint32_t count = 0;
+    for (uint32_t direction = 0; direction < 4; direction++)
+        if ((neighbours & (1u << direction)) && owner_at(g, neighbour_at(g, index, direction)) == player)
+            count++;
+    return count;
+}
+
+/**
+  * Zbiór pól gracza: wolne pola sąsiadujące z jego polami (free_adjacent)
+  * lub pola innych graczy sąsiadujące z jego polami (golden_fields).
+  * Pozycję pola w zbiorze przechowuje tablica positions gracza, więc zbiór
+  * może mieć co najwyżej UINT32_MAX pól.
+  */
+
+typedef struct frontier_set
+{
+    uint64_t **fields; ///< tablica indeksów pól zbioru
+    uint64_t *count; ///< liczba pól w zbiorze
+    uint64_t *capacity; ///< rozmiar zaalokowanej tablicy
+    journal_array_t array; ///< rodzaj tablicy w dzienniku zmian
+} frontier_set_t;
+
+/** @brief Wybiera zbiór pól gracza
+ * @param[in, out] info   – gracz,
+ * @param[in] vacant   – czy wybrać zbiór wolnych pól (true) czy pól innych graczy (false),
+ * @return Opis wybranego zbioru.
+ */
+
+static frontier_set_t frontier_set(player_t *info, bool vacant)
+{
+    if (vacant)
+        return (frontier_set_t) {&info->free_adjacent, &info->free_adjacent_fields,
+                                 &info->free_adjacent_capacity, JOURNAL_FREE_ADJACENT};
+    return (frontier_set_t) {&info->golden_fields, &info->golden_fields_count,
+                             &info->golden_fields_capacity, JOURNAL_GOLDEN_FIELDS};
+}
+
+/** @brief Dodaje pole do zbioru free_adjacent lub golden_fields gracza
+ * Powiększa dwukrotnie tablicę, jeśli się zapełniła.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] vacant   – czy pole jest wolne,
+ * @param[in] index   – indeks dodawanego pola,
+ */
+
+static void frontier_insert(gamma_t *g, uint32_t player, bool vacant, uint64_t index)
+{
+    own_player_tables(g, player);
+    player_t *info = &g->player_info[player];
+    frontier_set_t set = frontier_set(info, vacant);
+    // Pozycja kolejnego pola nie zmieściłaby się w tablicy positions.
+    if (*set.count == UINT32_MAX)
+        exit(1);
+    if (*set.count == *set.capacity)
+    {
+        *set.capacity = *set.capacity == 0 ? 4 : 2 * *set.capacity;
+        *set.fields = realloc(*set.fields, *set.capacity * sizeof **set.fields);
+        checkNull(*set.fields);
+    }
+    journal_save_element(g, JOURNAL_POSITION, player, index);
+    journal_save_element(g, set.array, player, *set.count);
+    journal_save(g, set.count, sizeof *set.count);
+    position_set(&info->positions, index, (uint32_t) *set.count);
+    (*set.fields)[(*set.count)++] = index;
+}
+
+/** @brief Usuwa pole ze zbioru free_adjacent lub golden_fields gracza
+ * Na miejsce usuwanego pola wstawia ostatnie pole zbioru.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ * @param[in] vacant   – czy pole jest wolne,
+ * @param[in] index   – indeks usuwanego pola,
+ */
+
+static void frontier_remove(gamma_t *g, uint32_t player, bool vacant, uint64_t index)
+{
+    own_player_tables(g, player);
+    player_t *info = &g->player_info[player];
+    frontier_set_t set = frontier_set(info, vacant);
+    uint32_t position = position_get(&info->positions, index);
+    journal_save(g, set.count, sizeof *set.count);
+    uint64_t last = (*set.fields)[--(*set.count)];
+    journal_save_element(g, set.array, player, position);
+    (*set.fields)[position] = last;
+    journal_save_element(g, JOURNAL_POSITION, player, last);
+    position_set(&info->positions, last, position);
+    journal_save_element(g, JOURNAL_POSITION, player, index);
+    position_remove(&info->positions, index);
+}
+
+/** @brief Aktualizuje zbiory graczy sąsiadujących z polem obok pola, które zmieniło właściciela
+ * Gdy zmienione pole było wolne, ustawia jego bit w masce zajętych sąsiadów
+ * pola. Gdy stary właściciel przestaje albo nowy zaczyna sąsiadować z polem,
+ * aktualizuje jego zbiór free_adjacent (jeśli pole jest wolne) lub jego zbiór
+ * golden_fields (jeśli pole należy do kogoś innego).
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] old_owner   – poprzedni właściciel zmienionego pola,
+ * @param[in] new_owner   – nowy właściciel zmienionego pola,
+ * @param[in] index   – indeks sąsiada,
+ * @param[in] direction   – kierunek, w którym sąsiad ma zmienione pole,
+ */
+
+static void update_neighbour(gamma_t *g, uint32_t old_owner, uint32_t new_owner, uint64_t index, uint32_t direction)
+{
+    uint32_t owner = owner_at(g, index);
+    if (old_owner == 0)
+    {
+        journal_save_element(g, JOURNAL_NEIGHBOURS, 0, index);
+        *neighbours_slot(g, index) |= 1u << direction;
+    }
+    else if (owner != old_owner && count_neighbours(g, index, old_owner) == 0)
+        frontier_remove(g, old_owner, owner == 0, index);
+
+    if (owner != new_owner && count_neighbours(g, index, new_owner) == 1)
+        frontier_insert(g, new_owner, owner == 0, index);
+}
+
+void frontier_update(gamma_t *g, uint32_t old_owner, uint32_t x, uint32_t y)
+{
+    uint64_t index = field_index(g, x, y);
+    uint32_t new_owner = owner_at(g, index);
+    uint32_t players[4];
+    uint32_t count = neighbour_players(g, index, players);
+
+    // Zajęte wolne pole przestaje być dostępne dla wszystkich sąsiadów i staje się
+    // obce dla każdego z nich poza nowym właścicielem. Przy złotym ruchu pole
+    // przestaje być obce dla nowego właściciela, a staje się obce dla poprzedniego.
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (old_owner == 0)
+            frontier_remove(g, players[i], true, index);
+        if (players[i] == new_owner)
+        {
+            if (old_owner != 0)
+                frontier_remove(g, new_owner, false, index);
+        }
+        else if (old_owner == 0 || players[i] == old_owner)
+            frontier_insert(g, players[i], false, index);
+    }
+
+    // Sąsiad w kierunku i ma zmienione pole w kierunku przeciwnym, i ^ 1.
+    if (x > 0)
+        update_neighbour(g, old_owner, new_owner, index - 1, 1);
+    if (x < g->max_width - 1)
+        update_neighbour(g, old_owner, new_owner, index + 1, 0);
+    if (y > 0)
+        update_neighbour(g, old_owner, new_owner, index - g->max_width, 3);
+    if (y < g->max_height - 1)
+        update_neighbour(g, old_owner, new_owner, index + g->max_width, 2);
+}
@@ -0,0 +1,30 @@
+/** @file
+ * Interfejs klasy przechowującej pola sąsiadujące z obszarami graczy
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 26.05.2020
+ */
+
+#ifndef GAMMA_FRONTIER_H
+#define GAMMA_FRONTIER_H
+
+#include <inttypes.h>
+#include "gamma.h"
+#include "gamma_t.h"
+
+/** @brief Aktualizuje sąsiedztwo pól po zmianie właściciela pola
+ * Właściciel pola (@p x, @p y) musi już być ustawiony na nowego gracza.
+ * Aktualizuje listę graczy sąsiadujących z polami wokół (@p x, @p y),
+ * zbiory wolnych pól sąsiadujących z polami każdego gracza
+ * oraz zbiory pól innych graczy sąsiadujących z polami każdego gracza.
+ * Koszt jest stały i nie zależy od rozmiaru planszy.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] old_owner   – poprzedni właściciel pola (0 jeśli było wolne),
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ */
+
+void frontier_update(gamma_t *g, uint32_t old_owner, uint32_t x, uint32_t y);
+
+#endif //GAMMA_FRONTIER_H
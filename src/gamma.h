@@ -11,12 +11,22 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 /**
  * Struktura przechowująca stan gry.
  */
 typedef struct gamma gamma_t;
 
+/**
+ * Współrzędne pola planszy.
+ */
+typedef struct gamma_position
+{
+    uint32_t x; ///< numer kolumny
+    uint32_t y; ///< numer wiersza
+} gamma_position_t;
+
 /** @brief Tworzy strukturę przechowującą stan gry.
  * Alokuje pamięć na nową strukturę przechowującą stan gry.
  * Inicjuje tę strukturę tak, aby reprezentowała początkowy stan gry.
@@ -38,6 +48,45 @@ gamma_t* gamma_new(uint32_t width, uint32_t height,
  */
 void gamma_delete(gamma_t *g);
 
+/** @brief Tworzy kopię stanu gry.
+ * Kopia początkowo współdzieli z grą @p g fragmenty planszy i tablice
+ * obszarów graczy. Fragment jest kopiowany dopiero wtedy, gdy któraś z gier
+ * zacznie korzystać z jego pól, więc koszt utworzenia kopii zależy od liczby
+ * fragmentów planszy i graczy, a nie od liczby pól. Obie gry mogą być potem
+ * używane niezależnie, także w różnych wątkach. Kopia ma pusty dziennik
+ * cofania ruchów, włączony wtedy, gdy jest włączony w grze @p g.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci lub parametr @p g jest niepoprawny.
+ */
+gamma_t* gamma_clone(gamma_t *g);
+
+/** @brief Zapisuje stan gry do pliku.
+ * Zapisuje planszę, stan graczy (obszary, ich rozmiary, wykorzystanie
+ * złotego ruchu, liczbę pól, na które mogą się rozszerzyć) i liczniki gry
+ * w formacie binarnym, który może wczytać funkcja @ref gamma_load.
+ * Plik zależy od wersji formatu i architektury, na której go zapisano.
+ * Dziennik cofania ruchów nie jest zapisywany.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] path    – ścieżka do pliku.
+ * @return Wartość @p true, jeśli udało się zapisać stan gry, a @p false
+ * w przeciwnym przypadku.
+ */
+bool gamma_save(gamma_t *g, const char *path);
+
+/** @brief Wczytuje stan gry z pliku.
+ * Mapuje do pamięci plik utworzony przez @ref gamma_save. Wczytana gra
+ * korzysta bezpośrednio z pamięci pliku i kopiuje fragment planszy lub
+ * tablice gracza dopiero przy ich pierwszym użyciu, więc czas wczytania nie
+ * zależy od liczby pól. Zmiany stanu gry nie trafiają do pliku. Dziennik
+ * cofania ruchów wczytanej gry jest wyłączony.
+ * @param[in] path    – ścieżka do pliku.
+ * @return Wskaźnik na wczytaną strukturę lub NULL, gdy nie udało się
+ * otworzyć pliku lub zaalokować pamięci albo plik nie pochodzi z tej samej
+ * wersji formatu i architektury.
+ */
+gamma_t* gamma_load(const char *path);
+
 /** @brief Wykonuje ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y).
  * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
@@ -89,10 +138,37 @@ uint64_t gamma_busy_fields(gamma_t *g, uint32_t player);
  */
 uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
 
+/** @brief Wypisuje pola, na których gracz może wykonać ruch.
+ * Zapisuje do tablicy @p out współrzędne co najwyżej @p cap pól, na których
+ * gracz @p player może wykonać zwykły ruch. Gracz, który ma już maksymalną
+ * liczbę obszarów, może zająć tylko wolne pola sąsiadujące z jego polami;
+ * są one przechowywane w zbiorze uaktualnianym przy każdym ruchu, więc ich
+ * wypisanie kosztuje tyle, ile jest pól w wyniku. W przeciwnym przypadku
+ * wypisywane są kolejne wolne pola planszy, wierszami od pola (0, 0).
+ * Kolejność pól w wyniku nie jest w żaden inny sposób określona.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] out    – tablica na co najwyżej @p cap współrzędnych pól,
+ *                      może być NULLem, jeśli @p cap jest zerem,
+ * @param[in] cap     – rozmiar tablicy @p out.
+ * @return Liczba wszystkich pól, na których gracz może wykonać ruch
+ * (równa wartości @ref gamma_free_fields), także gdy jest większa od
+ * @p cap, lub zero, jeśli któryś z parametrów jest niepoprawny.
+ */
+uint64_t gamma_legal_moves(gamma_t *g, uint32_t player, gamma_position_t *out, uint64_t cap);
+
 /** @brief Sprawdza, czy gracz może wykonać złoty ruch.
  * Sprawdza, czy gracz @p player jeszcze nie wykonał w tej rozgrywce złotego
  * ruchu i jest przynajmniej jedno pole zajęte przez innego gracza.
  * Jeśli tak, to sprawdza czy na jakimkolwiek polu na planszy rzeczywiście można wykonać złoty ruch.
+ * Nie przegląda planszy. Gracz, który ma mniej niż maksymalną liczbę
+ * obszarów, jest sprawdzany w czasie stałym. Pozostali gracze mają
+ * sprawdzane kolejne pola innych graczy sąsiadujące z ich polami,
+ * zaczynając od ostatnio znalezionego dobrego pola, więc koszt wynosi
+ * O(k), gdzie k jest liczbą takich pól (co najwyżej czterokrotność liczby
+ * pól gracza). Dochodzi do tego przejście dfsem po każdym obszarze
+ * sprawdzanych pól, który zmienił się od poprzedniego przejścia.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
  *                      @p players z funkcji @ref gamma_new.
@@ -103,14 +179,87 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
  */
 bool gamma_golden_possible(gamma_t *g, uint32_t player);
 
+/** @brief Podaje hasz pozycji.
+ * Hasz Zobrista obejmuje właścicieli wszystkich pól i to, którzy gracze
+ * wykonali już złoty ruch. Te same pozycje mają ten sam hasz niezależnie
+ * od kolejności ruchów, które do nich doprowadziły. Hasz jest uaktualniany
+ * przy każdym ruchu i jego cofnięciu, więc funkcja działa w czasie stałym.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Hasz pozycji lub zero, jeśli parametr jest niepoprawny.
+ * Pusta plansza bez wykonanych złotych ruchów ma hasz zero.
+ */
+uint64_t gamma_hash(gamma_t *g);
+
 /** @brief Daje napis opisujący stan planszy.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
  * opis aktualnego stanu planszy. Przykład znajduje się w pliku gamma_test.c.
  * Funkcja wywołująca musi zwolnić ten bufor.
+ * Napis jest nową kopią, więc funkcja zawsze działa w czasie i pamięci
+ * proporcjonalnych do rozmiaru planszy, także gdy opis planszy jest
+ * zapamiętany. Bez kopiowania całego opisu działają @ref gamma_board_rows
+ * i @ref gamma_board_print.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
  * @return Wskaźnik na zaalokowany bufor zawierający napis opisujący stan
  * planszy lub NULL, jeśli nie udało się zaalokować pamięci.
  */
 char* gamma_board(gamma_t *g);
 
+/** @brief Zapisuje do bufora napis opisujący wybrane wiersze planszy.
+ * Wiersze są numerowane tak jak w napisie zwracanym przez @ref gamma_board,
+ * wiersz 0 to górny wiersz planszy. Podobnie jak snprintf zapisuje co najwyżej
+ * @p size - 1 znaków i kończy napis znakiem '\0', jeśli @p size jest dodatnie.
+ * Nie alokuje pamięci.
+ * @param[in] g         – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] first_row – numer pierwszego wiersza,
+ * @param[in] rows      – liczba wierszy,
+ * @param[out] buffer   – bufor na napis, może być NULL gdy @p size jest zerem,
+ * @param[in] size      – rozmiar bufora.
+ * @return Długość napisu opisującego wybrane wiersze bez kończącego znaku '\0',
+ * także gdy nie zmieścił się w buforze, lub zero, jeśli któryś
+ * z parametrów jest niepoprawny.
+ */
+uint64_t gamma_board_rows(gamma_t *g, uint32_t first_row, uint32_t rows,
+                          char *buffer, uint64_t size);
+
+/** @brief Wypisuje napis opisujący stan planszy do strumienia.
+ * Wypisuje ten sam napis co @ref gamma_board, ale fragmentami przez bufor
+ * stałego rozmiaru, bez alokowania pamięci na całą planszę.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] stream  – strumień, do którego wypisuje napis.
+ * @return Wartość @p true, jeśli udało się wypisać napis, a @p false,
+ * gdy zapis się nie powiódł lub któryś z parametrów jest niepoprawny.
+ */
+bool gamma_board_print(gamma_t *g, FILE *stream);
+
+/** @brief Włącza lub wyłącza dziennik cofania ruchów.
+ * Przy włączonym dzienniku każdy udany ruch i złoty ruch zapisuje poprzednie
+ * wartości zmienianych danych, dzięki czemu można go cofnąć funkcją
+ * @ref gamma_undo w czasie proporcjonalnym do liczby tych zmian.
+ * Zarówno włączenie, jak i wyłączenie dziennika zapomina zapisane ruchy.
+ * Dziennik jest domyślnie wyłączony.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] enabled – czy dziennik ma być włączony.
+ * @return Wartość @p true, jeśli zmieniono ustawienie dziennika,
+ * a @p false, gdy parametr @p g jest niepoprawny.
+ */
+bool gamma_set_journal(gamma_t *g, bool enabled);
+
+/** @brief Cofa ostatni ruch zapisany w dzienniku.
+ * Przywraca stan gry sprzed ostatniego niecofniętego ruchu lub złotego
+ * ruchu wykonanego przy włączonym dzienniku.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli cofnięto ruch, a @p false, gdy nie ma
+ * ruchu do cofnięcia lub parametr @p g jest niepoprawny.
+ */
+bool gamma_undo(gamma_t *g);
+
+/** @brief Powtarza ostatnio cofnięty ruch.
+ * Cofnięte ruchy można powtarzać w odwrotnej kolejności cofania, dopóki
+ * nie zostanie wykonany nowy ruch.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli powtórzono ruch, a @p false, gdy nie ma
+ * ruchu do powtórzenia lub parametr @p g jest niepoprawny.
+ */
+bool gamma_redo(gamma_t *g);
+
 #endif /* GAMMA_H */
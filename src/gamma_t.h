@@ -10,6 +10,7 @@
 #define GAMMA_GAMMA_T_H
 
 #include <inttypes.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
@@ -28,16 +29,52 @@ uint32_t log_10(uint32_t x);
 void checkNull(void *pointer);
 
 
+/** Logarytm dwójkowy długości boku kwadratowego fragmentu rzadkiej planszy */
+#define TILE_SHIFT 3
+
+/** Długość boku kwadratowego fragmentu rzadkiej planszy */
+#define TILE_SIDE (1u << TILE_SHIFT)
+
+/** Logarytm dwójkowy liczby kolejnych pól w bloku ciągłej planszy */
+#define BLOCK_SHIFT 10
+
+/** Liczba kolejnych pól w bloku ciągłej planszy */
+#define BLOCK_FIELDS (1u << BLOCK_SHIFT)
+
+/**
+  * Struktura opisująca fragment rzadkiej planszy w tablicy haszującej
+  * lub blok kolejnych pól ciągłej planszy. Każda informacja o polach leży
+  * w osobnej tablicy przechowującej pola wierszami, więc przejścia planszy
+  * czytają tylko potrzebne im tablice. Numery obszarów, właściciele
+  * i sąsiedzi pól leżą w jednej alokacji z licznikiem gier, które ją
+  * współdzielą (zob. @ref gamma_clone). Numery przejść i liczby części
+  * nie należą do stanu gry, więc każda gra ma własne.
+  */
+
+typedef struct tile
+{
+    uint64_t key; ///< numer fragmentu: wiersz fragmentu w starszych, kolumna w młodszych 32 bitach
+    uint32_t *areas; ///< numery obszarów, do których należą pola (0 dla wolnych pól, NULL gdy wpis jest pusty)
+    void *owners; ///< właściciele pól
+    uint8_t *neighbours; ///< zajęci sąsiedzi pól: bit i oznacza zajętego sąsiada w kierunku i (0 – lewo, 1 – prawo, 2 – dół, 3 – góra)
+    uint32_t *visits; ///< numery przejść, w których pola ostatnio odwiedzono (NULL dopóki nie są potrzebne)
+    uint8_t *pieces; ///< na ile części rozpadnie się obszar po zabraniu pola (aktualne, gdy obszar jest oznaczony w @ref cut_cache_t), w jednej alokacji z visits
+    bool shared; ///< flaga informująca czy pamięć fragmentu może być współdzielona z inną grą
+} tile_t;
+
 /**
-  * Struktura przechowująca informacje o pojedynczym polu planszy
+  * Tablica z haszowaniem otwartym przypisująca polom ich pozycje w zbiorach
+  * free_adjacent i golden_fields gracza. Pole należy do co najwyżej jednego
+  * z tych zbiorów, więc ma co najwyżej jedną pozycję.
   */
 
-typedef struct field
+typedef struct position_map
 {
-    uint32_t owner; ///< numer gracza posiadające to pole (domyślnie 0)
-    uint32_t area; ///< numer obszaru do którego pole należy (domyślnie 0)
-    bool visited; ///< pomocnicza flaga używana przy przechodzeniu za pomocą bfs
-} field_t;
+    uint64_t *keys; ///< indeksy pól powiększone o 1, 0 oznacza wolne miejsce
+    uint32_t *positions; ///< pozycje pól o kluczach z tych samych miejsc tablicy keys
+    uint64_t capacity; ///< rozmiar tablic keys i positions: 0 lub potęga dwójki
+    uint64_t count; ///< liczba pól w tablicy
+} position_map_t;
 
 /**
   * Struktura przechowująca informacje o graczu
@@ -45,14 +82,148 @@ typedef struct field
 
 typedef struct player
 {
-    uint64_t free_adjacent_fields; ///< liczba dostępnych pól gdy osiągnięto maksymalną liczbę obszarów
+    uint64_t free_adjacent_fields; ///< liczba dostępnych pól gdy osiągnięto maksymalną liczbę obszarów, czyli pól w zbiorze free_adjacent
+    uint64_t *free_adjacent; ///< zbiór indeksów wolnych pól sąsiadujących z polami gracza
+    uint64_t free_adjacent_capacity; ///< rozmiar zaalokowanej tablicy free_adjacent
     bool used_golden_move; ///< flaga informująca czy gracz użył już swojego złotego ruchu
     uint32_t current_areas; ///< liczba posiadanych różnych spójnych obszarów
-    uint32_t *area_number; ///< tablica przechowująca unikalne numery różnych obszarów
-    uint64_t *area_size; ///< tablica przechowująca rozmiar obszaru o numerze i pod indeksem i
+    uint32_t *area_parent; ///< las numerów obszarów: rodzic numeru i (i dla korzenia), dla wolnego numeru następny wolny numer
+    uint64_t *area_size; ///< tablica przechowująca rozmiar obszaru o korzeniu i pod indeksem i
+    uint64_t *area_refs; ///< liczba pól i numerów obszarów, których rodzicem jest numer i
+    uint64_t area_capacity; ///< rozmiar zaalokowanych tablic area_parent, area_size i area_refs
+    uint32_t free_area_number; ///< początek listy zwolnionych numerów obszarów (0 gdy lista jest pusta)
+    uint32_t used_area_numbers; ///< największy dotychczas przydzielony numer obszaru
     uint64_t busy_fields; ///< liczba zajętych przez gracza pól
+    uint64_t *golden_fields; ///< zbiór indeksów pól innych graczy sąsiadujących z polami gracza
+    uint64_t golden_fields_count; ///< liczba pól w zbiorze golden_fields
+    uint64_t golden_fields_capacity; ///< rozmiar zaalokowanej tablicy golden_fields
+    position_map_t positions; ///< pozycje pól w zbiorach free_adjacent i golden_fields
+    uint64_t golden_witness; ///< pozycja w golden_fields, od której zaczyna się szukanie złotego ruchu
+    atomic_uint *tables_references; ///< liczba gier współdzielących tablice area_parent, area_size, area_refs, free_adjacent, golden_fields i positions (NULL gdy nieznana)
+    bool tables_shared; ///< flaga informująca czy tablice gracza mogą być współdzielone z inną grą
 } player_t;
 
+/**
+  * Pamięć podręczna punktów artykulacji obszarów gracza należąca do jednej gry.
+  * Wartości pieces pól obszaru (zob. @ref tile_t) są aktualne tylko wtedy,
+  * gdy obszar jest oznaczony w tablicy valid. Jedyne pole obszaru rozpada
+  * się na zero części niezależnie od swojej wartości pieces.
+  */
+
+typedef struct cut_cache
+{
+    uint8_t *valid; ///< czy wartości pieces pól obszaru o korzeniu i są aktualne (NULL dopóki gracz nie był sprawdzany)
+    uint64_t valid_capacity; ///< rozmiar tablicy valid
+} cut_cache_t;
+
+/**
+  * Struktura implementująca kolejkę indeksów pól w buforze cyklicznym.
+  */
+
+typedef struct queue
+{
+    uint64_t *buffer; ///< bufor cykliczny o rozmiarze będącym potęgą dwójki
+    uint64_t capacity; ///< rozmiar bufora
+    uint64_t begin; ///< pozycja pierwszego elementu w buforze
+    uint64_t size; ///< liczba elementów w kolejce
+} queue_t;
+
+/**
+  * Struktura przechowująca ostatnio utworzony opis planszy
+  * wraz z wierszami zmienionymi od jego utworzenia.
+  */
+
+typedef struct board_cache
+{
+    char *text; ///< ostatnio utworzony opis planszy (NULL gdy jeszcze nie powstał)
+    uint64_t *row_offset; ///< początek opisu wiersza i w text, pod indeksem wysokości długość całego opisu
+    uint64_t *dirty; ///< mapa bitowa wierszy opisu zmienionych od jego utworzenia
+    bool any_dirty; ///< flaga informująca czy jakiś wiersz jest oznaczony w dirty
+} board_cache_t;
+
+/**
+  * Rodzaj zmiennej zapisanej w dzienniku zmian.
+  */
+
+typedef enum journal_array
+{
+    JOURNAL_VARIABLE, ///< zmienna o stałym adresie
+    JOURNAL_AREA_LABEL, ///< numer obszaru pola planszy
+    JOURNAL_NEIGHBOURS, ///< zajęci sąsiedzi pola planszy
+    JOURNAL_OWNER, ///< właściciel pola planszy
+    JOURNAL_AREA_PARENT, ///< element tablicy area_parent gracza
+    JOURNAL_AREA_SIZE, ///< element tablicy area_size gracza
+    JOURNAL_AREA_REFS, ///< element tablicy area_refs gracza
+    JOURNAL_GOLDEN_FIELDS, ///< element tablicy golden_fields gracza
+    JOURNAL_FREE_ADJACENT, ///< element tablicy free_adjacent gracza
+    JOURNAL_POSITION, ///< pozycja pola w tablicy positions gracza
+    JOURNAL_CUT_VALID, ///< element tablicy valid pamięci podręcznej punktów artykulacji gracza
+    JOURNAL_PIECES ///< liczba części pola planszy (zob. pieces w @ref tile_t)
+} journal_array_t;
+
+/**
+  * Wpis dziennika zmian: poprzednia wartość zmienionej zmiennej.
+  * Elementy tablic graczy, które mogą zostać przeniesione przez realloc,
+  * są zapamiętywane przez numer gracza i indeks zamiast adresu. Podobnie
+  * dane pól planszy, których fragment może zostać skopiowany przy
+  * przejmowaniu go od kopii gry, są zapamiętywane przez indeks pola.
+  * Pozycje pól w tablicy positions są zapamiętywane przez indeks pola,
+  * bo ich miejsce w tablicy zmienia się przy jej powiększaniu.
+  */
+
+typedef struct journal_entry
+{
+    void *address; ///< adres zmiennej lub NULL dla elementu tablicy gracza
+    uint64_t old; ///< poprzednia wartość zmiennej
+    uint64_t index; ///< indeks elementu tablicy gracza lub indeks pola planszy
+    uint32_t player; ///< gracz, do którego należy tablica
+    uint8_t size; ///< rozmiar zmiennej w bajtach, dla pozycji pola 0 gdy pola nie było w tablicy
+    uint8_t array; ///< rodzaj tablicy gracza (zob. @ref journal_array_t)
+} journal_entry_t;
+
+/**
+  * Ruch zapisany w dzienniku zmian.
+  */
+
+typedef struct journal_move
+{
+    uint64_t first_entry; ///< indeks pierwszego wpisu ruchu w dzienniku
+    uint32_t player; ///< gracz wykonujący ruch
+    uint32_t x; ///< współrzędna x pola
+    uint32_t y; ///< współrzędna y pola
+    bool golden; ///< flaga informująca czy ruch był złotym ruchem
+} journal_move_t;
+
+/**
+  * Dziennik zmian pozwalający cofać i powtarzać ruchy.
+  */
+
+typedef struct journal
+{
+    bool enabled; ///< flaga informująca czy zmiany są zapisywane
+    bool redoing; ///< flaga informująca czy trwa powtarzanie ruchu
+    journal_entry_t *entries; ///< wpisy wykonanych ruchów w kolejności zmian
+    uint64_t entry_count; ///< liczba wpisów
+    uint64_t entry_capacity; ///< rozmiar tablicy entries
+    journal_move_t *moves; ///< wykonane ruchy, a za nimi cofnięte ruchy do powtórzenia
+    uint64_t move_count; ///< liczba wykonanych ruchów
+    uint64_t redo_count; ///< liczba cofniętych ruchów, które można powtórzyć
+    uint64_t move_capacity; ///< rozmiar tablicy moves
+} journal_t;
+
+/**
+  * Zmapowany do pamięci plik z zapisanym stanem gry (zob. @ref gamma_load).
+  * Fragmenty planszy i tablice graczy wczytanej gry wskazują na pamięć pliku,
+  * dopóki nie zostaną przejęte na wyłączność.
+  */
+
+typedef struct snapshot
+{
+    atomic_uint references; ///< liczba gier korzystających z pamięci pliku
+    void *address; ///< początek zmapowanego pliku
+    size_t size; ///< rozmiar zmapowanego pliku w bajtach
+} snapshot_t;
+
 /**
   * Struktura przechowująca stan gry
   */
@@ -65,8 +236,347 @@ struct gamma
     uint32_t players; ///< liczba graczy
     uint64_t free_fields; ///< liczba wolnych pól na planszy
     player_t *player_info; ///< tablica struktur przechowujących informacje o graczu i pod indeksem i
-    field_t ***board; ///< wskaźnik do dwuwymiarowej tablicy struktur pól planszy
+    tile_t *blocks; ///< bloki po @ref BLOCK_FIELDS kolejnych pól ciągłej planszy przechowywanej wierszami (NULL gdy plansza jest rzadka)
+    uint64_t blocks_count; ///< liczba bloków ciągłej planszy
+    uint32_t owner_bytes; ///< rozmiar numeru właściciela w tablicach owners w bajtach (1, 2 lub 4)
+    tile_t *tiles; ///< tablica haszująca założonych fragmentów rzadkiej planszy
+    uint64_t tiles_count; ///< liczba założonych fragmentów
+    uint64_t tiles_capacity; ///< rozmiar tablicy haszującej fragmentów, potęga dwójki
+    uint32_t visit_epoch; ///< ostatni zarezerwowany numer przejścia, pola z numerem mniejszym od pierwszego numeru przejścia są w nim nieodwiedzone
+    cut_cache_t *cut_caches; ///< pamięć podręczna punktów artykulacji każdego gracza (NULL dopóki nie jest potrzebna)
+    queue_t queues[4]; ///< kolejki przejść bfsem, po jednej na każdą część rozbijanego obszaru
+    void *scratch; ///< pamięć pomocnicza współdzielona przez przejścia dfsem
+    size_t scratch_size; ///< rozmiar pamięci scratch w bajtach
+    board_cache_t board_cache; ///< ostatnio utworzony opis ciągłej planszy
+    journal_t journal; ///< dziennik zmian do cofania ruchów
+    snapshot_t *snapshot; ///< plik, z którego wczytano grę lub jej pierwowzór (NULL gdy gra nie pochodzi z pliku)
+    uint64_t hash; ///< hasz Zobrista właścicieli pól i wykorzystanych złotych ruchów
 };
 
+/** @brief Oblicza indeks pola w tablicy planszy
+ * Pola są przechowywane wierszami, więc sąsiedzi w poziomie
+ * leżą w pamięci obok siebie.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @return Indeks pola w tablicy @p board.
+ */
+
+static inline uint64_t field_index(const struct gamma *g, uint32_t x, uint32_t y)
+{
+    return (uint64_t) y * g->max_width + x;
+}
+
+/** @brief Znajduje fragment rzadkiej planszy zawierający pole
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @return Wskaźnik na fragment lub NULL jeśli nie został założony.
+ */
+
+tile_t *sparse_tile(const struct gamma *g, uint32_t x, uint32_t y);
+
+/** @brief Przejmuje na wyłączność pamięć współdzielonego fragmentu
+ * Jeśli inna gra nadal korzysta z pamięci fragmentu, to kopiuje ją.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in, out] tile   – fragment rzadkiej planszy lub blok ciągłej planszy gry @p g,
+ */
+
+void tile_unshare(const struct gamma *g, tile_t *tile);
+
+/** @brief Przydziela fragmentowi tablice visits i pieces
+ * Wyzerowane tablice oznaczają pola nieodwiedzone, z nieobliczonym pieces.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in, out] tile   – fragment rzadkiej planszy lub blok ciągłej planszy gry @p g,
+ */
+
+void tile_visits(const struct gamma *g, tile_t *tile);
+
+/** @brief Zapewnia, że gra może zmieniać pamięć fragmentu
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in, out] tile   – fragment rzadkiej planszy lub blok ciągłej planszy gry @p g,
+ * @return Wskaźnik @p tile.
+ */
+
+static inline tile_t *own_tile(const struct gamma *g, tile_t *tile)
+{
+    if (tile->shared)
+        tile_unshare(g, tile);
+    return tile;
+}
+
+/** @brief Zwraca blok ciągłej planszy zawierający pole
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks pola obliczony przez @ref field_index,
+ * @return Wskaźnik na blok.
+ */
+
+static inline tile_t *dense_block(const struct gamma *g, uint64_t index)
+{
+    return &g->blocks[index >> BLOCK_SHIFT];
+}
+
+/** @brief Oblicza indeks pola we fragmencie rzadkiej planszy
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @return Indeks pola w tablicach fragmentu.
+ */
+
+static inline uint32_t tile_offset(uint32_t x, uint32_t y)
+{
+    return (y & (TILE_SIDE - 1)) * TILE_SIDE + (x & (TILE_SIDE - 1));
+}
+
+/** @brief Znajduje fragment zawierający pole i położenie pola w jego tablicach
+ * Na rzadkiej planszy pole musi być założone, co zachodzi dla pól zajętych
+ * i ich sąsiadów (zob. @ref board_materialize).
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks pola obliczony przez @ref field_index,
+ * @param[out] offset   – indeks pola w tablicach fragmentu,
+ * @return Wskaźnik na fragment rzadkiej planszy lub blok ciągłej planszy.
+ */
+
+static inline tile_t *tile_at(const struct gamma *g, uint64_t index, uint32_t *offset)
+{
+    if (g->blocks != NULL)
+    {
+        *offset = index & (BLOCK_FIELDS - 1);
+        return dense_block(g, index);
+    }
+    uint32_t x = index % g->max_width;
+    uint32_t y = index / g->max_width;
+    *offset = tile_offset(x, y);
+    return sparse_tile(g, x, y);
+}
+
+/** @brief Odczytuje numer obszaru pola o podanym indeksie
+ * Nie przejmuje współdzielonego fragmentu, więc odczyt pola kopii gry
+ * nie kopiuje jego pamięci.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks założonego pola,
+ * @return Numer obszaru zapisany w polu, 0 dla wolnego pola.
+ */
+
+static inline uint32_t area_at(const struct gamma *g, uint64_t index)
+{
+    uint32_t offset;
+    return tile_at(g, index, &offset)->areas[offset];
+}
+
+/** @brief Zwraca wskaźnik na numer obszaru pola o podanym indeksie
+ * Numer może być zmieniany, więc współdzielony fragment z tym polem
+ * jest najpierw przejmowany.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks założonego pola,
+ * @return Wskaźnik na numer obszaru pola.
+ */
+
+static inline uint32_t *area_slot(const struct gamma *g, uint64_t index)
+{
+    uint32_t offset;
+    return &own_tile(g, tile_at(g, index, &offset))->areas[offset];
+}
+
+/** @brief Odczytuje zajętych sąsiadów pola o podanym indeksie
+ * Nie przejmuje współdzielonego fragmentu, tak jak @ref area_at.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks założonego pola,
+ * @return Maska zajętych sąsiadów pola (zob. neighbours w @ref tile_t).
+ */
+
+static inline uint8_t neighbours_at(const struct gamma *g, uint64_t index)
+{
+    uint32_t offset;
+    return tile_at(g, index, &offset)->neighbours[offset];
+}
+
+/** @brief Zwraca wskaźnik na maskę zajętych sąsiadów pola o podanym indeksie
+ * Przejmuje współdzielony fragment, tak jak @ref area_slot.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks założonego pola,
+ * @return Wskaźnik na maskę zajętych sąsiadów pola.
+ */
+
+static inline uint8_t *neighbours_slot(const struct gamma *g, uint64_t index)
+{
+    uint32_t offset;
+    return &own_tile(g, tile_at(g, index, &offset))->neighbours[offset];
+}
+
+/** @brief Zwraca wskaźnik na numer przejścia, w którym ostatnio odwiedzono pole
+ * Nie przejmuje pamięci fragmentu, bo numery przejść należą tylko do gry @p g.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks założonego pola,
+ * @return Wskaźnik na numer przejścia pola.
+ */
+
+static inline uint32_t *visit_at(const struct gamma *g, uint64_t index)
+{
+    uint32_t offset;
+    tile_t *tile = tile_at(g, index, &offset);
+    if (tile->visits == NULL)
+        tile_visits(g, tile);
+    return &tile->visits[offset];
+}
+
+/** @brief Zwraca wskaźnik na liczbę części pola o podanym indeksie
+ * Nie przejmuje pamięci fragmentu, tak jak @ref visit_at.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks założonego pola,
+ * @return Wskaźnik na liczbę części, na które rozpadnie się obszar po zabraniu pola.
+ */
+
+static inline uint8_t *pieces_at(const struct gamma *g, uint64_t index)
+{
+    uint32_t offset;
+    tile_t *tile = tile_at(g, index, &offset);
+    if (tile->visits == NULL)
+        tile_visits(g, tile);
+    return &tile->pieces[offset];
+}
+
+/** @brief Definiuje odczyt i zapis właściciela w tablicy elementów o podanej liczbie bitów
+ * @param[in] bits   – liczba bitów numeru właściciela,
+ */
+
+#define OWNER_ACCESSORS(bits)                                                   \
+    static inline uint32_t load_owner_##bits(const void *owners, uint64_t i)   \
+    {                                                                           \
+        return ((const uint##bits##_t *) owners)[i];                            \
+    }                                                                           \
+    static inline void store_owner_##bits(void *owners, uint64_t i, uint32_t owner) \
+    {                                                                           \
+        ((uint##bits##_t *) owners)[i] = (uint##bits##_t) owner;                \
+    }
+
+OWNER_ACCESSORS(8)
+OWNER_ACCESSORS(16)
+OWNER_ACCESSORS(32)
+
+/** @brief Odczytuje właściciela z tablicy owners
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] owners   – tablica właścicieli planszy lub fragmentu,
+ * @param[in] i   – indeks pola w tablicy,
+ * @return Numer właściciela pola.
+ */
+
+static inline uint32_t load_owner(const struct gamma *g, const void *owners, uint64_t i)
+{
+    switch (g->owner_bytes)
+    {
+        case 1:
+            return load_owner_8(owners, i);
+        case 2:
+            return load_owner_16(owners, i);
+        default:
+            return load_owner_32(owners, i);
+    }
+}
+
+/** @brief Zwraca właściciela pola o podanych współrzędnych
+ * Działa dla dowolnego pola planszy, niezałożone pola rzadkiej planszy są wolne.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @return Numer właściciela pola lub 0 jeśli pole jest wolne.
+ */
+
+static inline uint32_t get_owner(const struct gamma *g, uint32_t x, uint32_t y)
+{
+    if (g->blocks != NULL)
+    {
+        uint64_t index = field_index(g, x, y);
+        return load_owner(g, dense_block(g, index)->owners, index & (BLOCK_FIELDS - 1));
+    }
+    tile_t *tile = sparse_tile(g, x, y);
+    return tile != NULL ? load_owner(g, tile->owners, tile_offset(x, y)) : 0;
+}
+
+/** @brief Zwraca właściciela pola o podanym indeksie
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] index   – indeks pola obliczony przez @ref field_index,
+ * @return Numer właściciela pola lub 0 jeśli pole jest wolne.
+ */
+
+static inline uint32_t owner_at(const struct gamma *g, uint64_t index)
+{
+    if (g->blocks != NULL)
+        return load_owner(g, dense_block(g, index)->owners, index & (BLOCK_FIELDS - 1));
+    return get_owner(g, index % g->max_width, index / g->max_width);
+}
+
+/** @brief Miesza bity liczby (funkcja kończąca generatora splitmix64)
+ * @param[in] z   – liczba,
+ * @return Liczba o pseudolosowych bitach, różna dla różnych @p z.
+ */
+
+static inline uint64_t zobrist_mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    return z ^ (z >> 31);
+}
+
+/** @brief Wyznacza klucz Zobrista pola zajętego przez gracza
+ * Klucze nie są przechowywane w tablicy, bo plansza i liczba graczy
+ * mogą być zbyt duże, tylko wyliczane z indeksu pola i numeru gracza.
+ * @param[in] index   – indeks pola,
+ * @param[in] owner   – numer właściciela pola,
+ * @return Klucz pola, 0 dla wolnego pola.
+ */
+
+static inline uint64_t zobrist_owner(uint64_t index, uint32_t owner)
+{
+    return owner == 0 ? 0 : zobrist_mix(zobrist_mix(index) ^ owner);
+}
+
+/** @brief Wyznacza klucz Zobrista wykorzystanego złotego ruchu gracza
+ * @param[in] player   – numer gracza,
+ * @return Klucz złotego ruchu gracza.
+ */
+
+static inline uint64_t zobrist_golden(uint32_t player)
+{
+    return zobrist_mix((uint64_t) player * 0xD1B54A32D192ED03u + 0x2545F4914F6CDD1Du);
+}
+
+/** @brief Ustawia właściciela pola o podanych współrzędnych
+ * Na rzadkiej planszy pole musi być założone, tak jak w @ref tile_at.
+ * Uaktualnia hasz gry, więc przywrócenie poprzedniego właściciela
+ * przywraca też poprzedni hasz.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @param[in] owner   – numer nowego właściciela,
+ */
+
+static inline void set_owner(struct gamma *g, uint32_t x, uint32_t y, uint32_t owner)
+{
+    uint64_t index = field_index(g, x, y);
+    uint64_t i;
+    void *owners;
+    if (g->blocks != NULL)
+    {
+        owners = own_tile(g, dense_block(g, index))->owners;
+        i = index & (BLOCK_FIELDS - 1);
+    }
+    else
+    {
+        owners = own_tile(g, sparse_tile(g, x, y))->owners;
+        i = tile_offset(x, y);
+    }
+    g->hash ^= zobrist_owner(index, load_owner(g, owners, i)) ^ zobrist_owner(index, owner);
+    switch (g->owner_bytes)
+    {
+        case 1:
+            store_owner_8(owners, i, owner);
+            break;
+        case 2:
+            store_owner_16(owners, i, owner);
+            break;
+        default:
+            store_owner_32(owners, i, owner);
+    }
+}
 
 #endif //GAMMA_GAMMA_T_H
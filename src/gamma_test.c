@@ -12,6 +12,7 @@
 #endif
 
 #include "gamma.h"
+#include "area.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -93,6 +94,290 @@ int main() {
     printf(p);
     free(p);
 
+    char rows[25];
+    assert(gamma_board_rows(g, 8, 2, rows, sizeof rows) == 22);
+    assert(strcmp(rows, board + 88) == 0);
+    assert(gamma_board_rows(g, 0, 10, rows, 5) == 110);
+    assert(strcmp(rows, "1...") == 0);
+    assert(gamma_board_rows(g, 9, 2, rows, sizeof rows) == 0);
+
+    gamma_delete(g);
+
+    g = gamma_new(UINT32_MAX, UINT32_MAX, 2, 1);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, UINT32_MAX - 1, 0));
+    assert(gamma_move(g, 1, UINT32_MAX - 2, 0));
+    assert(gamma_move(g, 2, UINT32_MAX - 3, 0));
+    assert(!gamma_move(g, 2, 100000, 100000));
+    assert(gamma_free_fields(g, 1) == 2);
+    assert(gamma_free_fields(g, 2) == 2);
+    assert(gamma_golden_possible(g, 2));
+    assert(gamma_golden_move(g, 2, UINT32_MAX - 2, 0));
+    assert(gamma_busy_fields(g, 1) == 1);
+    assert(gamma_busy_fields(g, 2) == 2);
+    assert(gamma_free_fields(g, 1) == 1);
+    assert(gamma_board(g) == NULL);
+    gamma_delete(g);
+
+    // Złote ruchy gracza 2 rozspójniłyby linię gracza 1 poza jej końcami,
+    // a szukanie ich nie zależy od rozmiaru planszy.
+    g = gamma_new(UINT32_MAX, UINT32_MAX, 2, 1);
+    assert(g != NULL);
+    for (uint32_t x = 0; x < 2000; x++)
+        assert(gamma_move(g, 1, UINT32_MAX - 2000 + x, UINT32_MAX / 2));
+    for (uint32_t x = 1; x < 1999; x++)
+        assert(gamma_move(g, 2, UINT32_MAX - 2000 + x, UINT32_MAX / 2 + 1));
+    for (uint32_t i = 0; i < 1000; i++)
+        assert(!gamma_golden_possible(g, 2));
+    assert(gamma_move(g, 2, UINT32_MAX - 1, UINT32_MAX / 2 + 1));
+    for (uint32_t i = 0; i < 100000; i++)
+        assert(gamma_golden_possible(g, 2));
+    assert(!gamma_golden_move(g, 2, UINT32_MAX - 1000, UINT32_MAX / 2));
+    assert(gamma_golden_move(g, 2, UINT32_MAX - 1, UINT32_MAX / 2));
+    assert(gamma_busy_fields(g, 1) == 1999);
+    gamma_delete(g);
+
+    g = gamma_new(10, 10, 100000, 100000);
+    assert(g != NULL);
+    for (uint32_t i = 0; i < 50; i++)
+        assert(gamma_move(g, 100000, 2 * (i % 5), i / 5));
+    assert(gamma_busy_fields(g, 100000) == 50);
+    assert(gamma_golden_move(g, 1, 0, 0));
+    gamma_delete(g);
+
+    g = gamma_new(3, 1, 300, 1);
+    assert(g != NULL);
+    assert(gamma_move(g, 300, 0, 0));
+    assert(gamma_move(g, 256, 2, 0));
+    p = gamma_board(g);
+    assert(p);
+    assert(strcmp(p, " 300  .  256 \n") == 0);
+    free(p);
+    gamma_delete(g);
+
+    g = gamma_new(3, 2, 2, 2);
+    assert(g != NULL);
+    assert(!gamma_undo(g));
+    assert(gamma_set_journal(g, true));
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 2, 2, 1));
+    assert(gamma_golden_move(g, 2, 0, 0));
+    assert(gamma_busy_fields(g, 1) == 1);
+    assert(gamma_undo(g));
+    assert(gamma_busy_fields(g, 1) == 2);
+    assert(gamma_golden_possible(g, 2));
+    assert(gamma_undo(g));
+    assert(gamma_undo(g));
+    p = gamma_board(g);
+    assert(p);
+    assert(strcmp(p, "...\n1..\n") == 0);
+    free(p);
+    assert(gamma_free_fields(g, 2) == 5);
+    assert(gamma_redo(g));
+    assert(gamma_redo(g));
+    assert(gamma_busy_fields(g, 2) == 1);
+    assert(gamma_move(g, 2, 2, 0));
+    assert(!gamma_redo(g));
+    assert(gamma_busy_fields(g, 2) == 2);
+    assert(gamma_set_journal(g, false));
+    assert(!gamma_undo(g));
+
+    gamma_t *h = gamma_clone(g);
+    assert(h != NULL);
+    assert(gamma_move(h, 1, 0, 1));
+    assert(gamma_golden_move(g, 1, 2, 0));
+    assert(gamma_busy_fields(g, 1) == 3);
+    assert(gamma_busy_fields(g, 2) == 1);
+    assert(gamma_busy_fields(h, 1) == 3);
+    assert(gamma_busy_fields(h, 2) == 2);
+    gamma_delete(g);
+    p = gamma_board(h);
+    assert(p);
+    assert(strcmp(p, "1.2\n112\n") == 0);
+    free(p);
+    assert(gamma_clone(NULL) == NULL);
+
+    assert(gamma_save(h, "gamma_test.snapshot"));
+    g = gamma_load("gamma_test.snapshot");
+    assert(g != NULL);
+    assert(remove("gamma_test.snapshot") == 0);
+    assert(gamma_move(h, 2, 1, 1));
+    assert(gamma_busy_fields(g, 1) == 3);
+    assert(gamma_busy_fields(g, 2) == 2);
+    assert(gamma_free_fields(g, 1) == 1);
+    assert(gamma_golden_possible(g, 1));
+    p = gamma_board(g);
+    assert(p);
+    assert(strcmp(p, "1.2\n112\n") == 0);
+    free(p);
+    gamma_delete(h);
+    h = gamma_clone(g);
+    assert(h != NULL);
+    gamma_delete(g);
+    assert(gamma_golden_move(h, 2, 0, 1));
+    assert(gamma_busy_fields(h, 1) == 2);
+    assert(gamma_load("gamma_test.snapshot") == NULL);
+    gamma_delete(h);
+
+    g = gamma_new(4, 4, 2, 3);
+    h = gamma_new(4, 4, 2, 3);
+    assert(g != NULL && h != NULL);
+    assert(gamma_hash(g) == 0);
+    assert(gamma_hash(NULL) == 0);
+    assert(gamma_set_journal(g, true));
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 2, 3, 3));
+    assert(gamma_hash(g) != 0);
+    assert(gamma_move(h, 2, 3, 3));
+    assert(gamma_move(h, 1, 0, 0));
+    assert(gamma_hash(g) == gamma_hash(h));
+    uint64_t hash = gamma_hash(g);
+    assert(gamma_golden_move(g, 1, 3, 3));
+    assert(gamma_hash(g) != hash);
+    assert(gamma_undo(g));
+    assert(gamma_hash(g) == hash);
+    assert(gamma_move(h, 1, 1, 0));
+    assert(gamma_hash(g) != gamma_hash(h));
+    gamma_delete(g);
+    gamma_delete(h);
+
+    // Cztery ramiona krzyża łączą się w jeden obszar, a złote ruchy
+    // odcinają od niego części, z dziennikiem i bez niego.
+    for (uint32_t journal = 0; journal < 2; journal++)
+    {
+        g = gamma_new(5, 5, 3, 4);
+        assert(g != NULL);
+        assert(gamma_set_journal(g, journal == 1));
+        assert(gamma_move(g, 1, 2, 0));
+        assert(gamma_move(g, 1, 2, 1));
+        assert(gamma_move(g, 1, 2, 3));
+        assert(gamma_move(g, 1, 2, 4));
+        assert(gamma_move(g, 1, 0, 2));
+        assert(gamma_move(g, 1, 1, 2));
+        assert(gamma_move(g, 1, 3, 2));
+        assert(gamma_move(g, 1, 4, 2));
+        assert(!gamma_move(g, 1, 0, 0));
+        assert(gamma_move(g, 1, 2, 2));
+        assert(gamma_move(g, 1, 0, 0));
+        assert(gamma_move(g, 1, 4, 4));
+        assert(gamma_move(g, 1, 0, 4));
+        assert(!gamma_move(g, 1, 4, 0));
+        assert(!gamma_golden_move(g, 2, 2, 2));
+        assert(gamma_golden_move(g, 2, 0, 0));
+        assert(gamma_golden_move(g, 3, 2, 1));
+        assert(!gamma_move(g, 1, 4, 0));
+        assert(gamma_move(g, 1, 1, 0));
+        assert(gamma_move(g, 1, 1, 1));
+        assert(gamma_move(g, 1, 4, 0));
+        assert(gamma_busy_fields(g, 1) == 13);
+        p = gamma_board(g);
+        assert(p);
+        assert(strcmp(p, "1.1.1\n..1..\n11111\n.13..\n211.1\n") == 0);
+
+        if (journal == 1)
+        {
+            uint32_t undone = 0;
+            while (gamma_undo(g))
+                undone++;
+            assert(undone == 17);
+            assert(gamma_busy_fields(g, 1) == 0);
+            while (gamma_redo(g))
+                undone--;
+            assert(undone == 0);
+            char *redone = gamma_board(g);
+            assert(redone);
+            assert(strcmp(p, redone) == 0);
+            free(redone);
+            assert(gamma_busy_fields(g, 3) == 1);
+            assert(gamma_move(g, 1, 3, 0));
+            assert(gamma_golden_possible(g, 1));
+        }
+        free(p);
+        gamma_delete(g);
+    }
+
+    // Złoty ruch na liść obszaru rozstrzyga się z otoczenia pola bez przechodzenia obszaru.
+    // Liczby części zapamiętane dla obszaru gracza 1 przeżywają ruchy, które
+    // nie mogą zmienić jego punktów artykulacji, także po cofnięciu ruchu.
+    g = gamma_new(5, 5, 2, 1);
+    assert(g != NULL);
+    assert(gamma_set_journal(g, true));
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 1, 2, 0));
+    assert(gamma_move(g, 2, 0, 1));
+    assert(!area_pieces_known(g, 1, 0));
+    assert(area_local_pieces(g, 0, 0) == 1);
+    assert(area_local_pieces(g, 1, 0) == 2);
+    assert(gamma_golden_possible(g, 2));
+    assert(!area_pieces_known(g, 1, 0));
+    assert(area_count_pieces(g, 1, 0) == 2);
+    assert(area_pieces_known(g, 1, 0));
+    assert(gamma_move(g, 2, 0, 2));
+    assert(gamma_move(g, 2, 0, 3));
+    assert(gamma_move(g, 1, 3, 0));
+    assert(gamma_move(g, 1, 1, 1));
+    assert(area_pieces_known(g, 1, 0));
+    assert(area_count_pieces(g, 0, 0) == 1);
+    assert(area_count_pieces(g, 1, 0) == 3);
+    assert(area_count_pieces(g, 2, 0) == 2);
+    assert(area_count_pieces(g, 3, 0) == 1);
+    assert(gamma_move(g, 1, 2, 1));
+    assert(!area_pieces_known(g, 1, 0));
+    assert(area_count_pieces(g, 1, 0) == 2);
+    assert(area_count_pieces(g, 1, 1) == 1);
+    assert(area_pieces_known(g, 1, 0));
+    assert(gamma_undo(g));
+    assert(area_pieces_known(g, 1, 0));
+    assert(area_count_pieces(g, 1, 0) == 3);
+    assert(area_count_pieces(g, 1, 1) == 1);
+    assert(area_count_pieces(g, 0, 2) == 2);
+    assert(gamma_golden_move(g, 2, 1, 1));
+    assert(area_pieces_known(g, 0, 1));
+    assert(area_count_pieces(g, 0, 1) == 2);
+    assert(!area_pieces_known(g, 1, 0));
+    assert(area_count_pieces(g, 1, 0) == 2);
+    gamma_delete(g);
+
+    // Złoty ruch rozbijający obszar rozstrzyga się jednym przejściem, które
+    // zostaje wykorzystane przy zabraniu pola, a odrzucony nie zmienia gry.
+    for (uint32_t areas = 1; areas <= 2; areas++)
+    {
+        g = gamma_new(5, 5, 2, areas);
+        assert(g != NULL);
+        assert(gamma_move(g, 1, 0, 0));
+        assert(gamma_move(g, 1, 1, 0));
+        assert(gamma_move(g, 1, 2, 0));
+        assert(gamma_move(g, 2, 1, 1));
+        uint64_t hash = gamma_hash(g);
+        assert(gamma_golden_move(g, 2, 1, 0) == (areas == 2));
+        assert(!area_pieces_known(g, 0, 0));
+        assert(gamma_busy_fields(g, 1) == 4 - areas);
+        assert(!gamma_golden_possible(g, 2));
+        assert((gamma_hash(g) == hash) == (areas == 1));
+        gamma_delete(g);
+    }
+
+    gamma_position_t moves[9];
+    g = gamma_new(3, 3, 2, 1);
+    assert(g != NULL);
+    assert(gamma_legal_moves(g, 3, moves, 9) == 0);
+    assert(gamma_legal_moves(g, 1, NULL, 0) == 9);
+    assert(gamma_move(g, 1, 1, 1));
+    assert(gamma_legal_moves(g, 1, moves, 9) == 4);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        assert(moves[i].x == 1 || moves[i].y == 1);
+        assert(moves[i].x != moves[i].y);
+    }
+    assert(gamma_legal_moves(g, 2, moves, 3) == 8);
+    assert(moves[0].x == 0 && moves[0].y == 0);
+    assert(moves[2].x == 2 && moves[2].y == 0);
+    assert(gamma_move(g, 2, 1, 0));
+    assert(gamma_legal_moves(g, 1, moves, 9) == 3);
+    assert(gamma_legal_moves(g, 2, moves, 1) == 2);
+    assert(moves[0].y == 0 && moves[0].x != 1);
     gamma_delete(g);
     return 0;
 }
@@ -11,105 +11,185 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include <stdbool.h>
-#include <errno.h>
 #include <stdint.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include "gamma_t.h"
 #include "gamma.h"
 #include "batch_mode.h"
+#include "binary_mode.h"
+#include "multi_mode.h"
+#include "input.h"
 #include "interactive_mode.h"
 
-void skipWhitespace(char **string)
+/** Początkowy rozmiar bufora na dane wczytywane ze strumienia */
+#define READER_BUFFER_SIZE ((size_t) 1 << 20)
+
+/** @brief Sprawdza czy znak jest białym znakiem oddzielającym wyrazy
+ * @param[in] c   – sprawdzany znak,
+ * @return Zwraca true dla białych znaków innych niż '\n', false w przeciwnym wypadku.
+ */
+
+static bool is_separator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r';
+}
+
+/** @brief Sprawdza czy znak jest cyfrą
+ * @param[in] c   – sprawdzany znak,
+ * @return Zwraca true jeśli znak jest cyfrą, false w przeciwnym wypadku.
+ */
+
+static bool is_digit(char c)
 {
-    while (**string && isspace(**string) && **string != '\n')
-        (*string)++;
+    return (unsigned char) c >= '0' && (unsigned char) c <= '9';
 }
 
-bool isNumberOfWordsCorrect(char *string, uint32_t number)
+bool parse_parameters(const char *string, size_t length, uint32_t number, uint32_t *values)
 {
-    uint32_t counter = 0;
-    char prev;
+    const char *end = string + length;
+    bool error = false;
 
     for (uint32_t i = 0; i < number; i++)
     {
-        char a = *string;
-        skipWhitespace(&string);
-        char b = *string;
-        if(a == b)
+        const char *word = string;
+        while (string < end && is_separator(*string))
+            string++;
+        if (string == word || string == end || !is_digit(*string))
             return false;
 
-        prev = *string;
+        // Tak jak strtoul z podstawą 0: wiodące zero oznacza liczbę ósemkową,
+        // której zapis kończy się na pierwszej cyfrze 8 lub 9.
+        uint32_t base = *string == '0' ? 8 : 10;
+        uint64_t value = 0;
+        bool counting = true;
+        for (; string < end && is_digit(*string); string++)
+        {
+            uint32_t digit = *string - '0';
+            if (digit >= base)
+                counting = false;
+            if (!counting)
+                continue;
+            value = value * base + digit;
+            if (value > UINT32_MAX)
+            {
+                error = true;
+                counting = false;
+            }
+        }
+        values[i] = value;
+    }
+
+    while (string < end && is_separator(*string))
+        string++;
+    return !error && string + 1 == end && *string == '\n';
+}
 
-        while (*string && !isspace(*string) && (unsigned char) *string >= '0' && (unsigned char) *string <= '9')
-            string++;
+void reader_open(line_reader_t *reader, FILE *stream)
+{
+    *reader = (line_reader_t) {stream, NULL, 0, 0, 0, 0, false};
 
-        if (*string != prev)
-            counter++;
+    // Zwykły plik mapujemy w całości i zaczynamy od miejsca, w którym
+    // stdio skończyło czytanie, uwzględniając jego bufor.
+    struct stat info;
+    long position = ftell(stream);
+    if (position >= 0 && fstat(fileno(stream), &info) == 0 && S_ISREG(info.st_mode)
+        && info.st_size > position)
+    {
+        void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fileno(stream), 0);
+        if (mapping != MAP_FAILED)
+        {
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+            reader->data = mapping;
+            reader->mapping_size = info.st_size;
+            reader->begin = position;
+            reader->end = info.st_size;
+            reader->eof = true;
+            return;
+        }
     }
-    skipWhitespace(&string);
-
-    if (*string == '\n' && counter == number)
-        return true;
 
-    return false;
+    reader->capacity = READER_BUFFER_SIZE;
+    reader->data = malloc(reader->capacity);
+    checkNull(reader->data);
 }
 
-/** @brief Oblicza długość wyrazu zawartego w napisie
- * Przechodzi przez napis dopóki nie napotka białego znaku
- * lub końca napisu
- * @param[in] string   – napis zawierający wyraz,
- * @return Zwraca długość wyrazu zawartego w napisie
+/** @brief Wczytuje kolejny blok danych do bufora
+ * Nieprzetworzone dane przesuwa na początek bufora, a jeśli zajmują
+ * cały bufor, to go powiększa.
+ * @param[in, out] reader   – struktura wczytująca dane,
  */
 
-static int wordLength(char *string)
+static void reader_refill(line_reader_t *reader)
 {
-    int length = 0;
-    while (*string && !isspace(*string))
+    size_t pending = reader->end - reader->begin;
+    memmove(reader->data, reader->data + reader->begin, pending);
+    reader->begin = 0;
+    reader->end = pending;
+    if (pending == reader->capacity)
     {
-        string++;
-        length++;
+        reader->capacity *= 2;
+        reader->data = realloc(reader->data, reader->capacity);
+        checkNull(reader->data);
     }
-    return length;
+
+    size_t read = fread(reader->data + reader->end, 1, reader->capacity - reader->end, reader->stream);
+    reader->end += read;
+    if (read == 0)
+        reader->eof = true;
 }
 
-/** @brief Kopiuje zawartość jednego wyrazu do drugiego
- * Przechodzi przez wyraz źródłowy i kopiuje go znak po znaku do
- * wyrazu docelowego dopóki nie napotka '\n' lub końca napisu.
- * Dodaje również na koniec znak końca napisu.
- * @param[in] source   – wyraz źródłowy,
- * @param[in] destination   – wyraz docelowy
- */
+bool reader_next_line(line_reader_t *reader, const char **line, size_t *length)
+{
+    size_t searched = reader->begin;
+    while (true)
+    {
+        char *newline = memchr(reader->data + searched, '\n', reader->end - searched);
+        if (newline != NULL)
+        {
+            *line = reader->data + reader->begin;
+            *length = newline + 1 - *line;
+            reader->begin += *length;
+            return true;
+        }
+        if (reader->eof)
+            break;
+
+        searched = reader->end - reader->begin;
+        reader_refill(reader);
+    }
+
+    if (reader->begin == reader->end)
+        return false;
+    *line = reader->data + reader->begin;
+    *length = reader->end - reader->begin;
+    reader->begin = reader->end;
+    return true;
+}
 
-static void wordCopy(char *source, char *destination)
+bool reader_next_block(line_reader_t *reader, size_t size, const char **block)
 {
-    while (*source && !isspace(*source))
+    while (reader->end - reader->begin < size)
     {
-        *destination = *source;
-        destination++;
-        source++;
+        if (reader->eof)
+            return false;
+        reader_refill(reader);
     }
-    *destination = '\0';
+
+    *block = reader->data + reader->begin;
+    reader->begin += size;
+    return true;
 }
 
-uint32_t word_to_int(char **string, bool *error)
+void reader_close(line_reader_t *reader)
 {
-    (*string)++;
-    skipWhitespace(string);
-    char *word = malloc(wordLength(*string) + 1 * sizeof(char));
-    checkNull(word);
-
-    skipWhitespace(string);
-    wordCopy(*string, word);
-    *string += wordLength(*string);
-
-    uint64_t output = strtoul(word, NULL, 0);
-    free(word);
-    if(output > UINT32_MAX || errno != 0)
-        (*error) = true;
-    return output;
+    if (reader->capacity == 0)
+        munmap(reader->data, reader->mapping_size);
+    else
+        free(reader->data);
 }
 
 /** @brief Sprawdza czy plansza zmieściłaby się w oknie terminalu
@@ -138,39 +218,42 @@ void parseInput()
 {
     char *string = NULL;
     size_t size = 0;
+    ssize_t length;
     uint32_t line = 0;
     bool exit1 = false;
 
-    while (getline(&string, &size, stdin) != -1)
+    while ((length = getline(&string, &size, stdin)) != -1)
     {
         line++;
-        char *temp = string;
 
-        if (*temp == '#' || *temp == '\n')
+        if (*string == '#' || *string == '\n')
             continue;
 
-        char mode = *temp;
-        temp++;
+        char mode = *string;
+        uint32_t parameters[4];
+
+        uint32_t words = mode == 'M' ? 0 : 4;
 
-        if(!isNumberOfWordsCorrect(temp, 4) || (mode != 'B' && mode != 'I'))
+        if(!parse_parameters(string + 1, length - 1, words, parameters) ||
+           (mode != 'B' && mode != 'I' && mode != 'R' && mode != 'M'))
         {
             fprintf(stderr, "ERROR %u\n", line);
             continue;
         }
 
-        bool error = false;
-        uint32_t width = word_to_int(&temp, &error);
-        uint32_t height = word_to_int(&temp, &error);
-        uint32_t players = word_to_int(&temp, &error);
-        uint32_t areas = word_to_int(&temp, &error);
-
-        if(error)
+        if (mode == 'M')
         {
-            fprintf(stderr, "ERROR %u\n", line);
-            continue;
+            printf("OK %u\n", line);
+            multi_mode(line);
+            break;
         }
 
-        if (mode == 'B')
+        uint32_t width = parameters[0];
+        uint32_t height = parameters[1];
+        uint32_t players = parameters[2];
+        uint32_t areas = parameters[3];
+
+        if (mode == 'B' || mode == 'R')
         {
             gamma_t *g = gamma_new(width, height, players, areas);
             if(!g)
@@ -179,7 +262,10 @@ void parseInput()
                 continue;
             }
             printf("OK %u\n", line);
-            batch_mode(g, line);
+            if (mode == 'B')
+                batch_mode(g, line);
+            else
+                binary_mode(g);
             gamma_delete(g);
             break;
         }
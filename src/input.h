@@ -10,44 +10,84 @@
 #define GAMMA_INPUT_H
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
 
-/** @brief Pomija białe znaki w przekazanym napisie
- * Pomija wszystkie białe znaki oprócz '\n'
- * @param[in, out] string   – napis który przewijamy
+/**
+  * Struktura wczytująca kolejne wiersze lub bloki wejścia.
+  * Plik zwykły jest mapowany do pamięci w całości, a z innych strumieni
+  * dane są wczytywane dużymi blokami do bufora. Wiersze i bloki są zwracane
+  * jako wskaźniki do tych danych, bez kopiowania.
+  */
+
+typedef struct line_reader
+{
+    FILE *stream; ///< strumień, z którego wczytywane są dane
+    char *data; ///< wczytane dane (bufor lub zmapowany plik)
+    size_t begin; ///< pozycja początku nieprzetworzonych danych
+    size_t end; ///< pozycja końca wczytanych danych
+    size_t capacity; ///< rozmiar bufora (0 gdy dane są zmapowanym plikiem)
+    size_t mapping_size; ///< rozmiar zmapowanego pliku
+    bool eof; ///< flaga informująca czy wczytano już wszystkie dane
+} line_reader_t;
+
+/** @brief Przygotowuje wczytywanie wierszy ze strumienia
+ * Zaczyna od bieżącej pozycji strumienia, więc dane przeczytane
+ * wcześniej przez funkcje z stdio nie są wczytywane ponownie.
+ * @param[out] reader   – struktura wczytująca wiersze,
+ * @param[in] stream   – strumień wejściowy,
+ */
+
+void reader_open(line_reader_t *reader, FILE *stream);
+
+/** @brief Zwraca kolejny wiersz wejścia
+ * Wiersz obejmuje kończący go znak '\n', jeśli taki jest.
+ * Jest ważny do następnego wywołania funkcji.
+ * @param[in, out] reader   – struktura wczytująca wiersze,
+ * @param[out] line   – wskaźnik na początek wiersza,
+ * @param[out] length   – długość wiersza,
+ * @return Zwraca true jeśli wczytano wiersz, false na końcu wejścia.
  */
 
-void skipWhitespace(char **string);
+bool reader_next_line(line_reader_t *reader, const char **line, size_t *length);
 
-/** @brief Sprawdza czy liczba parametrów się zgadza
- * Sprawdza czy w przekazanym napisie mamy @param number liczbę
- * wyrazów które zawierają tylko cyfry
- * @param[in] string   – napis w którym sprawdzamy parametry,
- * @param[in] number   – sprawdzana liczba parametrów
- * @return Zwraca true jeśli liczba parametrów się zgadza lub
- * false jeśli liczba parametrów się nie zgadza albo występują znaki inne niż cyfry
+/** @brief Zwraca kolejny blok danych o zadanym rozmiarze
+ * Blok jest ważny do następnego wywołania funkcji wczytującej.
+ * @param[in, out] reader   – struktura wczytująca dane,
+ * @param[in] size   – rozmiar bloku w bajtach,
+ * @param[out] block   – wskaźnik na początek bloku,
+ * @return Zwraca true jeśli wczytano cały blok, false jeśli wejście
+ * skończyło się wcześniej.
  */
 
-bool isNumberOfWordsCorrect(char *string, uint32_t number);
-
-/** @brief Wyciąga liczbę z napisu i ją zwraca
- * Z przekazanego napisu wyciąga jeden wyraz i
- * wrzuca go do funkcji strtoul po czym sprawdza czy liczba mieści się
- * w uint32_t. Jeśli tak to ją zwraca, jeśli nie to zwraca 0.
- * Zmienia również flagę error w zależności od tego czy liczba mieści się w
- * uint32_t.
- * @param[in] string   – napis z którego wyciągamy liczbę,
- * @param[in, out] error - flaga informująca że wystąpił błąd.
- * @return Zwraca liczbę wyciągniętą z napisu lub 0 jeśli liczba jest większa niż
- * uint32_t.
+bool reader_next_block(line_reader_t *reader, size_t size, const char **block);
+
+/** @brief Zwalnia zasoby struktury wczytującej wiersze
+ * @param[in, out] reader   – struktura wczytująca wiersze,
+ */
+
+void reader_close(line_reader_t *reader);
+
+/** @brief Wczytuje parametry komendy
+ * Sprawdza czy napis składa się z dokładnie @p number wyrazów zawierających
+ * tylko cyfry, poprzedzonych białymi znakami innymi niż '\n', i kończy się
+ * znakiem '\n' poprzedzonym ewentualnie białymi znakami. Wartości wyrazów
+ * są obliczane tak jak przez strtoul z podstawą 0, zatem wyraz zaczynający
+ * się od zera jest liczbą ósemkową.
+ * @param[in] string   – napis z parametrami, zaczynający się za znakiem komendy,
+ * @param[in] length   – długość napisu,
+ * @param[in] number   – oczekiwana liczba parametrów,
+ * @param[out] values   – tablica na @p number wartości parametrów,
+ * @return Zwraca true jeśli parametry są poprawne i mieszczą się w uint32_t,
+ * false w przeciwnym wypadku.
  */
 
-uint32_t word_to_int(char **string, bool *error);
+bool parse_parameters(const char *string, size_t length, uint32_t number, uint32_t *values);
 
 /** @brief Główna funkcja obsługująca input
  * Zawiera główną pętlę przyjmującą input i wypissującą
  * ERROR line jeśli nie spełnia on specyfikacji
- * lub przechodzi do trybu wsadowego lub interaktywnego zależnie od
- * podanej komendy
+ * lub przechodzi do trybu wsadowego (B), binarnego (R), wielu gier (M)
+ * lub interaktywnego (I) zależnie od podanej komendy
  */
 
 void parseInput();
@@ -88,12 +88,13 @@ static void print_board(gamma_t *g, uint32_t row, uint32_t column, uint32_t play
     {
         for(uint32_t j = 0; j < g->max_width; j++)
         {
-            if(((*(g->board))[j][g->max_height - 1 - i]).owner == player)
+            uint32_t owner = get_owner(g, j, g->max_height - 1 - i);
+            if(owner == player)
                 printf("\033[31;1m");
             if(i == row && j == column)
                 printf("\033[47;1m\033[30;1m");
-            if(((*(g->board))[j][g->max_height - 1 - i]).owner != 0)
-                printf("%*u", log_10(g->players), ((*(g->board))[j][g->max_height - 1 - i]).owner);
+            if(owner != 0)
+                printf("%*u", log_10(g->players), owner);
             else
             {
                 printf("%*s.", log_10(g->players) - 1, "");
@@ -0,0 +1,171 @@
+/** @file
+ * Implementacja klasy przechowującej dziennik zmian do cofania ruchów
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 21.06.2020
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "journal.h"
+#include "player.h"
+#include "positions.h"
+
+/** @brief Wyznacza adres elementu tablicy gracza lub pola planszy
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] entry   – wpis dziennika dotyczący elementu tablicy,
+ * @param[out] size   – rozmiar elementu w bajtach,
+ * @return Adres elementu w bieżącej tablicy gracza lub fragmentu planszy.
+ */
+
+static void *element_address(gamma_t *g, const journal_entry_t *entry, size_t *size)
+{
+    player_t *info = &g->player_info[entry->player];
+    switch (entry->array)
+    {
+        case JOURNAL_AREA_PARENT:
+            *size = sizeof *(info->area_parent);
+            return &info->area_parent[entry->index];
+        case JOURNAL_AREA_SIZE:
+            *size = sizeof *(info->area_size);
+            return &info->area_size[entry->index];
+        case JOURNAL_AREA_REFS:
+            *size = sizeof *(info->area_refs);
+            return &info->area_refs[entry->index];
+        case JOURNAL_CUT_VALID:
+            *size = sizeof *(g->cut_caches[entry->player].valid);
+            return &g->cut_caches[entry->player].valid[entry->index];
+        case JOURNAL_PIECES:
+            *size = sizeof(uint8_t);
+            return pieces_at(g, entry->index);
+        case JOURNAL_AREA_LABEL:
+            *size = sizeof(uint32_t);
+            return area_slot(g, entry->index);
+        case JOURNAL_NEIGHBOURS:
+            *size = sizeof(uint8_t);
+            return neighbours_slot(g, entry->index);
+        case JOURNAL_FREE_ADJACENT:
+            *size = sizeof *(info->free_adjacent);
+            return &info->free_adjacent[entry->index];
+        default:
+            *size = sizeof *(info->golden_fields);
+            return &info->golden_fields[entry->index];
+    }
+}
+
+void journal_push(gamma_t *g, void *address, size_t size, journal_array_t array, uint32_t player, uint64_t index)
+{
+    journal_t *journal = &g->journal;
+    // Zmian sprzed pierwszego ruchu nie da się cofnąć, więc nie trzeba ich pamiętać.
+    if (journal->move_count == 0)
+        return;
+    if (journal->entry_count == journal->entry_capacity)
+    {
+        journal->entry_capacity = journal->entry_capacity == 0 ? 64 : 2 * journal->entry_capacity;
+        journal->entries = realloc(journal->entries, journal->entry_capacity * sizeof *(journal->entries));
+        checkNull(journal->entries);
+    }
+
+    journal_entry_t *entry = &journal->entries[(journal->entry_count)++];
+    *entry = (journal_entry_t) {NULL, 0, index, player, size, array};
+    switch (array)
+    {
+        case JOURNAL_VARIABLE:
+            entry->address = address;
+            break;
+        case JOURNAL_OWNER:
+            entry->old = owner_at(g, index);
+            return;
+        case JOURNAL_POSITION:
+        {
+            uint32_t position = 0;
+            if (!position_find(&g->player_info[player].positions, index, &position))
+                entry->size = 0;
+            else
+                entry->size = sizeof position;
+            entry->old = position;
+            return;
+        }
+        default:
+            address = element_address(g, entry, &size);
+            entry->size = size;
+    }
+    memcpy(&entry->old, address, size);
+}
+
+void journal_save_owner(gamma_t *g, uint32_t x, uint32_t y)
+{
+    if (g->journal.enabled)
+        journal_push(g, NULL, 0, JOURNAL_OWNER, 0, field_index(g, x, y));
+}
+
+void journal_begin_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, bool golden)
+{
+    journal_t *journal = &g->journal;
+    if (!journal->enabled)
+        return;
+
+    if (!journal->redoing)
+        journal->redo_count = 0;
+    if (journal->move_count == journal->move_capacity)
+    {
+        journal->move_capacity = journal->move_capacity == 0 ? 16 : 2 * journal->move_capacity;
+        journal->moves = realloc(journal->moves, journal->move_capacity * sizeof *(journal->moves));
+        checkNull(journal->moves);
+    }
+    journal->moves[(journal->move_count)++] = (journal_move_t) {journal->entry_count, player, x, y, golden};
+}
+
+const journal_move_t *journal_rollback(gamma_t *g)
+{
+    journal_t *journal = &g->journal;
+    if (journal->move_count == 0)
+        return NULL;
+
+    journal_move_t *move = &journal->moves[--(journal->move_count)];
+    while (journal->entry_count > move->first_entry)
+    {
+        journal_entry_t *entry = &journal->entries[--(journal->entry_count)];
+        size_t size = entry->size;
+        void *address = entry->address;
+        switch (entry->array)
+        {
+            case JOURNAL_VARIABLE:
+                break;
+            case JOURNAL_OWNER:
+                set_owner(g, entry->index % g->max_width, entry->index / g->max_width, entry->old);
+                continue;
+            case JOURNAL_POSITION:
+                own_player_tables(g, entry->player);
+                if (size == 0)
+                    position_remove(&g->player_info[entry->player].positions, entry->index);
+                else
+                    position_set(&g->player_info[entry->player].positions, entry->index, entry->old);
+                continue;
+            case JOURNAL_AREA_LABEL:
+            case JOURNAL_NEIGHBOURS:
+            case JOURNAL_CUT_VALID:
+            case JOURNAL_PIECES:
+                address = element_address(g, entry, &size);
+                break;
+            default:
+                own_player_tables(g, entry->player);
+                address = element_address(g, entry, &size);
+        }
+        memcpy(address, &entry->old, size);
+    }
+    (journal->redo_count)++;
+    return move;
+}
+
+void journal_clear(gamma_t *g)
+{
+    journal_t *journal = &g->journal;
+    free(journal->entries);
+    free(journal->moves);
+    journal->entries = NULL;
+    journal->moves = NULL;
+    journal->entry_count = journal->entry_capacity = 0;
+    journal->move_count = journal->redo_count = journal->move_capacity = 0;
+}
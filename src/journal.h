@@ -0,0 +1,94 @@
+/** @file
+ * Interfejs klasy przechowującej dziennik zmian do cofania ruchów
+ *
+ * Każda zmiana stanu gry wykonywana przez ruch jest poprzedzona zapisaniem
+ * poprzedniej wartości zmienianej zmiennej, o ile dziennik jest włączony.
+ * Cofnięcie ruchu przywraca zapisane wartości w odwrotnej kolejności.
+ * Nie są zapisywane zmiany pamięci podręcznej (numerów przejść pól,
+ * golden_witness) ani powiększenia tablic. Wyjątkiem są liczby części pól
+ * i flagi ich aktualności, bo po cofnięciu ruchu muszą opisywać przywrócone
+ * obszary. Zmiany sprzed pierwszego ruchu nie są zapisywane.
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 21.06.2020
+ */
+
+#ifndef GAMMA_JOURNAL_H
+#define GAMMA_JOURNAL_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "gamma.h"
+#include "gamma_t.h"
+
+/** @brief Dopisuje wpis do dziennika
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] address   – adres zmiennej lub NULL dla elementu tablicy gracza i właściciela pola,
+ * @param[in] size   – rozmiar zmiennej w bajtach, co najwyżej 8,
+ * @param[in] array   – rodzaj tablicy gracza,
+ * @param[in] player   – gracz, do którego należy tablica,
+ * @param[in] index   – indeks elementu tablicy gracza lub pola planszy,
+ */
+
+void journal_push(gamma_t *g, void *address, size_t size, journal_array_t array, uint32_t player, uint64_t index);
+
+/** @brief Zapisuje poprzednią wartość zmiennej, jeśli dziennik jest włączony
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] address   – adres zmiennej,
+ * @param[in] size   – rozmiar zmiennej w bajtach, co najwyżej 8,
+ */
+
+static inline void journal_save(gamma_t *g, void *address, size_t size)
+{
+    if (g->journal.enabled)
+        journal_push(g, address, size, JOURNAL_VARIABLE, 0, 0);
+}
+
+/** @brief Zapisuje poprzednią wartość elementu tablicy gracza, jeśli dziennik jest włączony
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] array   – rodzaj tablicy gracza,
+ * @param[in] player   – gracz, do którego należy tablica,
+ * @param[in] index   – indeks elementu,
+ */
+
+static inline void journal_save_element(gamma_t *g, journal_array_t array, uint32_t player, uint64_t index)
+{
+    if (g->journal.enabled)
+        journal_push(g, NULL, 0, array, player, index);
+}
+
+/** @brief Zapisuje poprzedniego właściciela pola, jeśli dziennik jest włączony
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ */
+
+void journal_save_owner(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Rozpoczyna zapisywanie ruchu, jeśli dziennik jest włączony
+ * Zapomina cofnięte ruchy, chyba że ruch jest właśnie powtarzany.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – gracz wykonujący ruch,
+ * @param[in] x   – współrzędna x pola,
+ * @param[in] y   – współrzędna y pola,
+ * @param[in] golden   – flaga informująca czy jest to złoty ruch,
+ */
+
+void journal_begin_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y, bool golden);
+
+/** @brief Przywraca wartości zmienione przez ostatni ruch
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @return Wskaźnik na cofnięty ruch lub NULL, jeśli nie ma ruchu do cofnięcia.
+ */
+
+const journal_move_t *journal_rollback(gamma_t *g);
+
+/** @brief Zapomina wszystkie zapisane ruchy i zwalnia pamięć dziennika
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ */
+
+void journal_clear(gamma_t *g);
+
+#endif //GAMMA_JOURNAL_H
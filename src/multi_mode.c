@@ -0,0 +1,520 @@
+/** @file
+ * Implementacja klasy obsługującej wsadowy tryb wielu gier
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.06.2020
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "multi_mode.h"
+#include "batch_mode.h"
+#include "input.h"
+#include "output.h"
+#include "gamma_t.h"
+#include "gamma.h"
+
+/** Liczba komend wykonywanych w jednej paczce */
+#define MULTI_BATCH_SIZE (1 << 16)
+/** Liczba bajtów opisów plansz, po której paczka jest wykonywana przed zapełnieniem */
+#define MULTI_BATCH_BYTES (1 << 26)
+/** Maksymalna liczba wątków wykonujących komendy */
+#define MAX_MULTI_WORKERS 64
+/** Oznaczenie braku kolejnej komendy gry */
+#define NO_COMMAND UINT32_MAX
+/** Maksymalna liczba parametrów komendy */
+#define MULTI_MAX_PARAMETERS 5
+
+/**
+ * Rodzaj wyniku komendy.
+ */
+
+typedef enum result_kind
+{
+    RESULT_NONE, ///< komenda nie wypisuje wyniku
+    RESULT_NUMBER, ///< wynikiem jest liczba
+    RESULT_OK, ///< gra została utworzona
+    RESULT_BOARD, ///< wynikiem jest opis planszy
+    RESULT_ERROR ///< komenda jest niepoprawna
+} result_kind_t;
+
+/**
+ * Komenda z paczki wraz z jej wynikiem.
+ */
+
+typedef struct multi_command
+{
+    char command; ///< litera komendy
+    result_kind_t kind; ///< rodzaj wyniku
+    uint32_t line; ///< numer wiersza z komendą
+    uint32_t parameters[MULTI_MAX_PARAMETERS]; ///< identyfikator gry i parametry komendy
+    uint32_t next; ///< indeks kolejnej komendy tej samej gry w paczce
+    uint64_t value; ///< wynik liczbowy
+    char *board; ///< opis planszy dla komendy p
+} multi_command_t;
+
+/**
+ * Gra o danym identyfikatorze.
+ */
+
+typedef struct game_slot
+{
+    uint32_t id; ///< identyfikator gry
+    gamma_t *g; ///< stan gry lub NULL, jeśli gra nie istnieje
+    uint32_t first; ///< indeks pierwszej komendy gry w paczce
+    uint32_t last; ///< indeks ostatniej komendy gry w paczce
+    uint64_t board_bytes; ///< górne ograniczenie długości opisu planszy gry
+} game_slot_t;
+
+/**
+ * Stan trybu wielu gier wspólny dla wszystkich wątków.
+ */
+
+typedef struct multi_state
+{
+    game_slot_t *slots; ///< tablica gier
+    uint32_t slot_count; ///< liczba gier
+    uint32_t slot_capacity; ///< rozmiar tablicy gier
+    uint32_t *table; ///< tablica haszująca, indeks gry + 1 lub 0
+    uint32_t table_size; ///< rozmiar tablicy haszującej, potęga dwójki
+    multi_command_t *commands; ///< komendy bieżącej paczki
+    uint32_t command_count; ///< liczba komend w paczce
+    uint32_t *touched; ///< indeksy gier, których dotyczą komendy paczki
+    uint32_t touched_count; ///< liczba gier w paczce
+    uint64_t board_bytes; ///< szacowana łączna długość opisów plansz paczki
+    pthread_mutex_t lock; ///< blokada chroniąca pola poniżej
+    pthread_cond_t start; ///< zmienna warunkowa budząca wątki
+    pthread_cond_t done; ///< zmienna warunkowa budząca wątek główny
+    uint64_t generation; ///< numer bieżącej paczki
+    uint32_t next_game; ///< indeks kolejnej gry do wykonania
+    uint32_t running; ///< liczba wątków, które nie skończyły paczki
+    bool stop; ///< flaga informująca wątki o zakończeniu pracy
+} multi_state_t;
+
+/** @brief Zwraca pozycję, od której zaczyna się szukanie identyfikatora
+ * @param[in] s   – stan trybu wielu gier,
+ * @param[in] id   – identyfikator gry,
+ * @return Pozycja w tablicy haszującej.
+ */
+
+static uint32_t table_home(multi_state_t *s, uint32_t id)
+{
+    return (id * 2654435761u) & (s->table_size - 1);
+}
+
+/** @brief Zwraca pozycję identyfikatora w tablicy haszującej
+ * @param[in] s   – stan trybu wielu gier,
+ * @param[in] id   – identyfikator gry,
+ * @return Pozycja gry o danym identyfikatorze lub pierwsza wolna pozycja.
+ */
+
+static uint32_t table_position(multi_state_t *s, uint32_t id)
+{
+    uint32_t mask = s->table_size - 1;
+    uint32_t position = table_home(s, id);
+
+    while (s->table[position] != 0 && s->slots[s->table[position] - 1].id != id)
+        position = (position + 1) & mask;
+    return position;
+}
+
+/** @brief Podwaja rozmiar tablicy haszującej
+ * @param[in, out] s   – stan trybu wielu gier,
+ */
+
+static void grow_table(multi_state_t *s)
+{
+    free(s->table);
+    s->table_size *= 2;
+    s->table = calloc(s->table_size, sizeof(uint32_t));
+    checkNull(s->table);
+
+    for (uint32_t i = 0; i < s->slot_count; i++)
+        s->table[table_position(s, s->slots[i].id)] = i + 1;
+}
+
+/** @brief Znajduje grę o danym identyfikatorze
+ * @param[in, out] s   – stan trybu wielu gier,
+ * @param[in] id   – identyfikator gry,
+ * @param[in] create   – flaga informująca czy dodać brakującą grę,
+ * @return Wskaźnik na grę lub NULL, jeśli jej nie ma i nie należało jej dodać.
+ */
+
+static game_slot_t *find_slot(multi_state_t *s, uint32_t id, bool create)
+{
+    uint32_t position = table_position(s, id);
+    if (s->table[position] != 0)
+        return &s->slots[s->table[position] - 1];
+    if (!create)
+        return NULL;
+
+    if (s->slot_count == s->slot_capacity)
+    {
+        s->slot_capacity *= 2;
+        s->slots = realloc(s->slots, s->slot_capacity * sizeof(game_slot_t));
+        checkNull(s->slots);
+    }
+    s->slots[s->slot_count] = (game_slot_t) {id, NULL, NO_COMMAND, NO_COMMAND, 0};
+    s->table[position] = ++s->slot_count;
+
+    if ((uint64_t) s->slot_count * 2 > s->table_size)
+        grow_table(s);
+    return &s->slots[s->slot_count - 1];
+}
+
+/** @brief Usuwa grę z tablicy gier i tablicy haszującej
+ * Pozycje za usuniętą, które do niej prowadziły, są przesuwane na jej miejsce,
+ * a ostatnia gra zajmuje jej miejsce w tablicy gier.
+ * @param[in, out] s   – stan trybu wielu gier,
+ * @param[in] index   – indeks usuwanej gry,
+ */
+
+static void remove_slot(multi_state_t *s, uint32_t index)
+{
+    uint32_t mask = s->table_size - 1;
+    uint32_t hole = table_position(s, s->slots[index].id);
+    for (uint32_t next = (hole + 1) & mask; s->table[next] != 0; next = (next + 1) & mask)
+    {
+        uint32_t home = table_home(s, s->slots[s->table[next] - 1].id);
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            s->table[hole] = s->table[next];
+            hole = next;
+        }
+    }
+    s->table[hole] = 0;
+
+    uint32_t last = --s->slot_count;
+    if (index != last)
+    {
+        s->slots[index] = s->slots[last];
+        s->table[table_position(s, s->slots[index].id)] = index + 1;
+    }
+}
+
+/** @brief Usuwa gry paczki, które zostały zakończone lub nie powstały
+ * Gra przeniesiona na miejsce usuniętej jest sprawdzana ponownie,
+ * bo również mogła należeć do paczki.
+ * @param[in, out] s   – stan trybu wielu gier,
+ */
+
+static void release_slots(multi_state_t *s)
+{
+    for (uint32_t k = 0; k < s->touched_count; k++)
+        while (s->touched[k] < s->slot_count && s->slots[s->touched[k]].g == NULL)
+            remove_slot(s, s->touched[k]);
+}
+
+/** @brief Szacuje z góry długość opisu planszy
+ * @param[in] width   – szerokość planszy,
+ * @param[in] height   – wysokość planszy,
+ * @param[in] players   – liczba graczy,
+ * @return Górne ograniczenie długości opisu lub @ref MULTI_BATCH_BYTES,
+ * jeśli opis może być dłuższy.
+ */
+
+static uint64_t board_bytes(uint32_t width, uint32_t height, uint32_t players)
+{
+    uint64_t field = players < 10 ? 1 : log_10(players) + 3;
+    uint64_t row = (uint64_t) width * field + 1;
+    if (height > 0 && row > MULTI_BATCH_BYTES / height)
+        return MULTI_BATCH_BYTES;
+    return row * height;
+}
+
+/** @brief Zwraca liczbę parametrów komendy
+ * @param[in] command   – litera komendy,
+ * @return Liczba parametrów wraz z identyfikatorem gry lub 0 dla
+ * nieznanej komendy.
+ */
+
+static uint32_t parameter_count(char command)
+{
+    switch (command)
+    {
+        case 'B':
+            return 5;
+        case 'm':
+        case 'g':
+            return 4;
+        case 'b':
+        case 'f':
+        case 'q':
+            return 2;
+        case 'p':
+        case 'D':
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/** @brief Dodaje komendę z wiersza do paczki
+ * Niepoprawna komenda i komenda dla nieistniejącej gry trafiają do paczki
+ * od razu z wynikiem @ref RESULT_ERROR. Komenda p zwiększa szacowaną
+ * łączną długość opisów plansz paczki.
+ * @param[in, out] s   – stan trybu wielu gier,
+ * @param[in] line   – numer wiersza,
+ * @param[in] string   – wiersz z komendą,
+ * @param[in] length   – długość wiersza,
+ */
+
+static void add_command(multi_state_t *s, uint32_t line, const char *string, size_t length)
+{
+    uint32_t index = s->command_count++;
+    multi_command_t *command = &s->commands[index];
+    *command = (multi_command_t) {*string, RESULT_ERROR, line, {0, 0, 0, 0, 0}, NO_COMMAND, 0, NULL};
+
+    uint32_t count = parameter_count(command->command);
+    if (count == 0 || !parse_parameters(string + 1, length - 1, count, command->parameters))
+        return;
+
+    game_slot_t *slot = find_slot(s, command->parameters[0], command->command == 'B');
+    if (slot == NULL)
+        return;
+
+    command->kind = RESULT_NONE;
+    if (command->command == 'B')
+    {
+        uint64_t bytes = board_bytes(command->parameters[1], command->parameters[2],
+                                     command->parameters[3]);
+        if (bytes > slot->board_bytes)
+            slot->board_bytes = bytes;
+    }
+    else if (command->command == 'p')
+    {
+        s->board_bytes += slot->board_bytes;
+    }
+    if (slot->first == NO_COMMAND)
+    {
+        slot->first = index;
+        s->touched[s->touched_count++] = slot - s->slots;
+    }
+    else
+    {
+        s->commands[slot->last].next = index;
+    }
+    slot->last = index;
+}
+
+/** @brief Wykonuje komendę w grze
+ * @param[in, out] slot   – gra,
+ * @param[in, out] command   – komenda, w której zapisywany jest wynik,
+ */
+
+static void execute_command(game_slot_t *slot, multi_command_t *command)
+{
+    uint32_t *parameters = command->parameters;
+
+    command->kind = RESULT_ERROR;
+    if (command->command == 'B')
+    {
+        if (slot->g == NULL)
+        {
+            slot->g = gamma_new(parameters[1], parameters[2], parameters[3], parameters[4]);
+            if (slot->g != NULL)
+                command->kind = RESULT_OK;
+        }
+        return;
+    }
+    if (slot->g == NULL)
+        return;
+
+    if (command->command == 'D')
+    {
+        gamma_delete(slot->g);
+        slot->g = NULL;
+        command->kind = RESULT_NONE;
+    }
+    else if (command->command == 'p')
+    {
+        command->board = gamma_board(slot->g);
+        if (command->board != NULL)
+            command->kind = RESULT_BOARD;
+    }
+    else if (batch_execute(slot->g, command->command, parameters + 1, &command->value))
+    {
+        command->kind = RESULT_NUMBER;
+    }
+}
+
+/** @brief Wykonuje komendy paczki dla kolejnych nieprzydzielonych gier
+ * @param[in, out] s   – stan trybu wielu gier,
+ */
+
+static void run_games(multi_state_t *s)
+{
+    while (true)
+    {
+        pthread_mutex_lock(&s->lock);
+        uint32_t k = s->next_game < s->touched_count ? s->next_game++ : NO_COMMAND;
+        pthread_mutex_unlock(&s->lock);
+        if (k == NO_COMMAND)
+            return;
+
+        game_slot_t *slot = &s->slots[s->touched[k]];
+        for (uint32_t i = slot->first; i != NO_COMMAND; i = s->commands[i].next)
+            execute_command(slot, &s->commands[i]);
+        slot->first = slot->last = NO_COMMAND;
+    }
+}
+
+/** @brief Główna funkcja wątku wykonującego komendy
+ * Czeka na kolejne paczki, dopóki wątek główny nie zakończy pracy.
+ * @param[in, out] arg   – stan trybu wielu gier,
+ * @return NULL.
+ */
+
+static void *worker(void *arg)
+{
+    multi_state_t *s = arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&s->lock);
+    while (true)
+    {
+        while (!s->stop && s->generation == seen)
+            pthread_cond_wait(&s->start, &s->lock);
+        if (s->stop)
+            break;
+        seen = s->generation;
+
+        pthread_mutex_unlock(&s->lock);
+        run_games(s);
+        pthread_mutex_lock(&s->lock);
+
+        if (--s->running == 0)
+            pthread_cond_signal(&s->done);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/** @brief Wykonuje paczkę i wypisuje jej wyniki w kolejności wierszy
+ * @param[in, out] s   – stan trybu wielu gier,
+ * @param[in] workers   – liczba uruchomionych wątków pomocniczych,
+ * @param[in, out] output   – struktura buforująca wyjście,
+ */
+
+static void run_batch(multi_state_t *s, uint32_t workers, output_t *output)
+{
+    pthread_mutex_lock(&s->lock);
+    s->next_game = 0;
+    s->running = workers;
+    s->generation++;
+    pthread_cond_broadcast(&s->start);
+    pthread_mutex_unlock(&s->lock);
+
+    run_games(s);
+
+    pthread_mutex_lock(&s->lock);
+    while (s->running > 0)
+        pthread_cond_wait(&s->done, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+
+    for (uint32_t i = 0; i < s->command_count; i++)
+    {
+        multi_command_t *command = &s->commands[i];
+        switch (command->kind)
+        {
+            case RESULT_NUMBER:
+                output_pair(output, command->parameters[0], command->value);
+                break;
+            case RESULT_OK:
+                output_ok(output, command->line);
+                break;
+            case RESULT_BOARD:
+                output_number(output, command->parameters[0]);
+                output_bytes(output, command->board, strlen(command->board));
+                free(command->board);
+                break;
+            case RESULT_ERROR:
+                output_error(output, command->line);
+                break;
+            case RESULT_NONE:
+                break;
+        }
+    }
+    release_slots(s);
+    s->command_count = 0;
+    s->touched_count = 0;
+    s->board_bytes = 0;
+}
+
+void multi_mode(uint32_t line)
+{
+    multi_state_t s = {0};
+    s.slot_capacity = 16;
+    s.slots = malloc(s.slot_capacity * sizeof(game_slot_t));
+    s.table_size = 32;
+    s.table = calloc(s.table_size, sizeof(uint32_t));
+    s.commands = malloc(MULTI_BATCH_SIZE * sizeof(multi_command_t));
+    s.touched = malloc(MULTI_BATCH_SIZE * sizeof(uint32_t));
+    checkNull(s.slots);
+    checkNull(s.table);
+    checkNull(s.commands);
+    checkNull(s.touched);
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.start, NULL);
+    pthread_cond_init(&s.done, NULL);
+
+    // Wątek główny również wykonuje komendy, więc uruchamiamy o jeden
+    // wątek mniej niż liczba procesorów.
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t count = MAX_MULTI_WORKERS;
+    if (processors > 0 && (uint64_t) processors < count)
+        count = processors;
+    pthread_t threads[MAX_MULTI_WORKERS];
+    uint32_t workers = 0;
+    for (uint32_t i = 1; i < count; i++)
+        if (pthread_create(&threads[workers], NULL, worker, &s) == 0)
+            workers++;
+
+    line_reader_t reader;
+    output_t output;
+    const char *string;
+    size_t length;
+
+    reader_open(&reader, stdin);
+    output_open(&output);
+    while (reader_next_line(&reader, &string, &length))
+    {
+        line++;
+
+        if (*string == '#' || *string == '\n')
+            continue;
+
+        add_command(&s, line, string, length);
+        // Opisy plansz są trzymane do wypisania całej paczki, więc ich
+        // łączny rozmiar również ogranicza paczkę.
+        if (s.command_count == MULTI_BATCH_SIZE || s.board_bytes >= MULTI_BATCH_BYTES)
+            run_batch(&s, workers, &output);
+    }
+    run_batch(&s, workers, &output);
+    output_close(&output);
+    reader_close(&reader);
+
+    pthread_mutex_lock(&s.lock);
+    s.stop = true;
+    pthread_cond_broadcast(&s.start);
+    pthread_mutex_unlock(&s.lock);
+    for (uint32_t i = 0; i < workers; i++)
+        pthread_join(threads[i], NULL);
+
+    for (uint32_t i = 0; i < s.slot_count; i++)
+        gamma_delete(s.slots[i].g);
+    pthread_cond_destroy(&s.done);
+    pthread_cond_destroy(&s.start);
+    pthread_mutex_destroy(&s.lock);
+    free(s.touched);
+    free(s.commands);
+    free(s.table);
+    free(s.slots);
+}
@@ -0,0 +1,37 @@
+/** @file
+ * Interfejs klasy obsługującej wsadowy tryb wielu gier
+ *
+ * Po wierszu nagłówka "M" i odpowiedzi "OK numer_wiersza" każdy wiersz
+ * zawiera komendę trybu wsadowego, w której pierwszym parametrem jest
+ * identyfikator gry, np. "m 7 1 0 0" to ruch gracza 1 w grze 7.
+ * Dodatkowe komendy to "B id szerokość wysokość gracze obszary",
+ * tworząca grę, i "D id", kończąca grę.
+ *
+ * Wyniki są wypisywane w kolejności wierszy wejścia: "id wynik" dla
+ * komend zwracających liczbę, "OK numer_wiersza" po utworzeniu gry,
+ * "id" i opis planszy dla komendy p oraz "ERROR numer_wiersza" na stderr.
+ * Kończenie gry nie wypisuje nic.
+ *
+ * Komendy są wykonywane w paczkach ograniczonych liczbą komend i łączną
+ * długością opisów plansz, które trzeba zachować do wypisania wyników.
+ * Komendy z paczki dotyczące jednej gry wykonuje po kolei jeden wątek,
+ * a różne gry są wykonywane równolegle.
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.06.2020
+ */
+
+#ifndef GAMMA_MULTI_MODE_H
+#define GAMMA_MULTI_MODE_H
+#include <inttypes.h>
+
+/** @brief Główna funkcja obsługująca wsadowy tryb wielu gier
+ * Funkcja wykonuje komendy z wejścia aż do jego końca,
+ * a następnie usuwa wszystkie gry.
+ * @param[in] line   – numer wiersza z nagłówkiem,
+ */
+
+void multi_mode(uint32_t line);
+
+#endif //GAMMA_MULTI_MODE_H
@@ -0,0 +1,176 @@
+/** @file
+ * Implementacja klasy buforującej wyjście trybu wsadowego
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.06.2020
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "gamma_t.h"
+#include "output.h"
+
+/** Indeks bufora stdout */
+#define OUTPUT_STDOUT 0
+/** Indeks bufora stderr */
+#define OUTPUT_STDERR 1
+/** Maksymalna długość jednego wypisywanego wiersza */
+#define OUTPUT_LINE_MAX 64
+
+/** @brief Wypisuje zawartość jednego bufora do jego strumienia
+ * @param[in, out] output   – struktura buforująca wyjście,
+ * @param[in] which   – indeks bufora,
+ */
+
+static void flush_one(output_t *output, int which)
+{
+    if (output->used[which] == 0)
+        return;
+
+    fwrite(output->data[which], 1, output->used[which], output->stream[which]);
+    fflush(output->stream[which]);
+    output->used[which] = 0;
+}
+
+/** @brief Rezerwuje w buforze miejsce na jeden wiersz
+ * Gdy strumienie są tym samym plikiem, najpierw opróżnia drugi bufor.
+ * @param[in, out] output   – struktura buforująca wyjście,
+ * @param[in] which   – indeks bufora,
+ * @return Wskaźnik na miejsce w buforze, w którym należy zapisać wiersz.
+ */
+
+static char *reserve_line(output_t *output, int which)
+{
+    if (output->shared)
+        flush_one(output, 1 - which);
+    if (output->used[which] + OUTPUT_LINE_MAX > OUTPUT_BUFFER_SIZE)
+        flush_one(output, which);
+
+    return output->data[which] + output->used[which];
+}
+
+/** @brief Zapisuje liczbę w systemie dziesiętnym
+ * @param[out] destination   – miejsce zapisu,
+ * @param[in] number   – zapisywana liczba,
+ * @return Liczba zapisanych znaków.
+ */
+
+static size_t format_number(char *destination, uint64_t number)
+{
+    char digits[20];
+    size_t length = 0;
+
+    do
+    {
+        digits[length++] = (char) ('0' + number % 10);
+        number /= 10;
+    } while (number > 0);
+
+    for (size_t i = 0; i < length; i++)
+        destination[i] = digits[length - 1 - i];
+
+    return length;
+}
+
+/** @brief Dopisuje do bufora wiersz złożony z przedrostka i liczb
+ * Liczby są oddzielone spacjami, a wiersz kończy znak nowej linii.
+ * @param[in, out] output   – struktura buforująca wyjście,
+ * @param[in] which   – indeks bufora,
+ * @param[in] prefix   – przedrostek wiersza, krótszy niż 16 znaków,
+ * @param[in] numbers   – wypisywane liczby,
+ * @param[in] count   – liczba liczb, co najwyżej 2,
+ */
+
+static void write_line(output_t *output, int which, const char *prefix, const uint64_t *numbers, uint32_t count)
+{
+    char *line = reserve_line(output, which);
+    size_t length = strlen(prefix);
+
+    memcpy(line, prefix, length);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i > 0)
+            line[length++] = ' ';
+        length += format_number(line + length, numbers[i]);
+    }
+    line[length++] = '\n';
+    output->used[which] += length;
+}
+
+void output_open(output_t *output)
+{
+    for (int which = OUTPUT_STDOUT; which <= OUTPUT_STDERR; which++)
+    {
+        output->data[which] = malloc(OUTPUT_BUFFER_SIZE);
+        checkNull(output->data[which]);
+        output->used[which] = 0;
+    }
+    output->stream[OUTPUT_STDOUT] = stdout;
+    output->stream[OUTPUT_STDERR] = stderr;
+
+    fflush(stdout);
+    fflush(stderr);
+
+    struct stat out_stat, err_stat;
+    output->shared = fstat(fileno(stdout), &out_stat) == 0 &&
+                     fstat(fileno(stderr), &err_stat) == 0 &&
+                     out_stat.st_dev == err_stat.st_dev &&
+                     out_stat.st_ino == err_stat.st_ino;
+}
+
+void output_number(output_t *output, uint64_t number)
+{
+    write_line(output, OUTPUT_STDOUT, "", &number, 1);
+}
+
+void output_pair(output_t *output, uint64_t first, uint64_t second)
+{
+    uint64_t numbers[2] = {first, second};
+    write_line(output, OUTPUT_STDOUT, "", numbers, 2);
+}
+
+void output_ok(output_t *output, uint32_t line)
+{
+    uint64_t number = line;
+    write_line(output, OUTPUT_STDOUT, "OK ", &number, 1);
+}
+
+void output_bytes(output_t *output, const void *data, size_t size)
+{
+    if (output->shared)
+        flush_one(output, OUTPUT_STDERR);
+    if (output->used[OUTPUT_STDOUT] + size > OUTPUT_BUFFER_SIZE)
+        flush_one(output, OUTPUT_STDOUT);
+
+    if (size > OUTPUT_BUFFER_SIZE)
+    {
+        fwrite(data, 1, size, stdout);
+        fflush(stdout);
+        return;
+    }
+    memcpy(output->data[OUTPUT_STDOUT] + output->used[OUTPUT_STDOUT], data, size);
+    output->used[OUTPUT_STDOUT] += size;
+}
+
+void output_error(output_t *output, uint32_t line)
+{
+    uint64_t number = line;
+    write_line(output, OUTPUT_STDERR, "ERROR ", &number, 1);
+}
+
+void output_flush(output_t *output)
+{
+    flush_one(output, OUTPUT_STDOUT);
+    flush_one(output, OUTPUT_STDERR);
+}
+
+void output_close(output_t *output)
+{
+    output_flush(output);
+    free(output->data[OUTPUT_STDOUT]);
+    free(output->data[OUTPUT_STDERR]);
+}
@@ -0,0 +1,99 @@
+/** @file
+ * Interfejs klasy buforującej wyjście trybu wsadowego
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.06.2020
+ */
+
+#ifndef GAMMA_OUTPUT_H
+#define GAMMA_OUTPUT_H
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * Rozmiar bufora jednego strumienia wyjściowego w bajtach.
+ */
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+/**
+  * Struktura buforująca wyniki komend trybu wsadowego.
+  * Wyniki i komunikaty o błędach są zbierane w osobnych buforach
+  * i wypisywane dużymi blokami.
+  *
+  * Kolejność wierszy w obrębie każdego strumienia jest zachowana.
+  * Jeśli stdout i stderr wskazują na ten sam plik (np. po 2>&1),
+  * przed dopisaniem do jednego bufora opróżniany jest drugi, więc
+  * w pliku wiersze pojawiają się w kolejności wykonania komend.
+  * W przeciwnym wypadku strumienie są opróżniane niezależnie: gdy
+  * bufor się zapełni, przy komendzie p i na końcu trybu wsadowego.
+  */
+
+typedef struct output
+{
+    char *data[2]; ///< bufory dla stdout i stderr
+    size_t used[2]; ///< liczba zajętych bajtów w buforach
+    FILE *stream[2]; ///< strumienie, do których trafiają bufory
+    bool shared; ///< flaga informująca czy oba strumienie to ten sam plik
+} output_t;
+
+/** @brief Przygotowuje buforowane wyjście
+ * Opróżnia bufory stdio, aby wcześniej wypisane wiersze
+ * poprzedzały wiersze wypisane przez bufor.
+ * @param[out] output   – struktura buforująca wyjście,
+ */
+
+void output_open(output_t *output);
+
+/** @brief Dopisuje do stdout liczbę zakończoną znakiem nowej linii
+ * @param[in, out] output   – struktura buforująca wyjście,
+ * @param[in] number   – wypisywana liczba,
+ */
+
+void output_number(output_t *output, uint64_t number);
+
+/** @brief Dopisuje do stdout wiersz z dwiema liczbami oddzielonymi spacją
+ * @param[in, out] output   – struktura buforująca wyjście,
+ * @param[in] first   – pierwsza liczba,
+ * @param[in] second   – druga liczba,
+ */
+
+void output_pair(output_t *output, uint64_t first, uint64_t second);
+
+/** @brief Dopisuje do stdout potwierdzenie wykonania komendy w danym wierszu
+ * @param[in, out] output   – struktura buforująca wyjście,
+ * @param[in] line   – numer wiersza z komendą,
+ */
+
+void output_ok(output_t *output, uint32_t line);
+
+/** @brief Dopisuje do stdout dane binarne
+ * @param[in, out] output   – struktura buforująca wyjście,
+ * @param[in] data   – wskaźnik na dane,
+ * @param[in] size   – rozmiar danych w bajtach,
+ */
+
+void output_bytes(output_t *output, const void *data, size_t size);
+
+/** @brief Dopisuje do stderr komunikat o błędzie w danym wierszu
+ * @param[in, out] output   – struktura buforująca wyjście,
+ * @param[in] line   – numer wiersza z błędem,
+ */
+
+void output_error(output_t *output, uint32_t line);
+
+/** @brief Wypisuje zawartość obu buforów
+ * Po wywołaniu można bezpośrednio pisać do stdout i stderr.
+ * @param[in, out] output   – struktura buforująca wyjście,
+ */
+
+void output_flush(output_t *output);
+
+/** @brief Wypisuje zawartość buforów i zwalnia je
+ * @param[in, out] output   – struktura buforująca wyjście,
+ */
+
+void output_close(output_t *output);
+
+#endif //GAMMA_OUTPUT_H
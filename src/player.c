@@ -0,0 +1,97 @@
+/** @file
+ * Implementacja klasy współdzielącej tablice graczy między kopiami gry
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 22.06.2020
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "player.h"
+
+/** @brief Tworzy kopię tablicy
+ * @param[in] array   – kopiowana tablica, może być NULLem,
+ * @param[in] size   – rozmiar tablicy w bajtach,
+ * @return Wskaźnik na kopię lub NULL, jeśli tablica jest pusta.
+ */
+
+static void *copy_array(const void *array, size_t size)
+{
+    if (array == NULL || size == 0)
+        return NULL;
+
+    void *copy = malloc(size);
+    checkNull(copy);
+    memcpy(copy, array, size);
+    return copy;
+}
+
+/** @brief Zwalnia tablice gracza wraz z licznikiem gier, które z nich korzystają
+ * @param[in, out] info   – gracz,
+ */
+
+static void free_tables(player_t *info)
+{
+    free(info->area_parent);
+    free(info->area_size);
+    free(info->area_refs);
+    free(info->free_adjacent);
+    free(info->golden_fields);
+    free(info->positions.keys);
+    free(info->positions.positions);
+    free(info->tables_references);
+}
+
+bool player_share_tables(player_t *info, player_t *copy)
+{
+    copy->tables_shared = false;
+    copy->tables_references = NULL;
+    if (info->area_parent == NULL && info->free_adjacent == NULL && info->golden_fields == NULL
+        && info->positions.keys == NULL)
+        return true;
+
+    if (info->tables_references == NULL)
+    {
+        info->tables_references = malloc(sizeof *(info->tables_references));
+        if (!info->tables_references)
+            return false;
+        atomic_init(info->tables_references, 1);
+    }
+    atomic_fetch_add_explicit(info->tables_references, 1, memory_order_relaxed);
+    copy->tables_references = info->tables_references;
+    info->tables_shared = true;
+    copy->tables_shared = true;
+    return true;
+}
+
+void player_unshare_tables(player_t *info)
+{
+    // Gra, która jako jedyna korzysta z tablic, może je zmieniać bez kopiowania.
+    atomic_uint *references = info->tables_references;
+    if (atomic_load_explicit(references, memory_order_acquire) != 1)
+    {
+        player_t old = *info;
+        info->area_parent = copy_array(old.area_parent, old.area_capacity * sizeof *(old.area_parent));
+        info->area_size = copy_array(old.area_size, old.area_capacity * sizeof *(old.area_size));
+        info->area_refs = copy_array(old.area_refs, old.area_capacity * sizeof *(old.area_refs));
+        info->free_adjacent = copy_array(old.free_adjacent,
+                                         old.free_adjacent_capacity * sizeof *(old.free_adjacent));
+        info->golden_fields = copy_array(old.golden_fields,
+                                         old.golden_fields_capacity * sizeof *(old.golden_fields));
+        info->positions.keys = copy_array(old.positions.keys, old.positions.capacity * sizeof *(old.positions.keys));
+        info->positions.positions = copy_array(old.positions.positions,
+                                               old.positions.capacity * sizeof *(old.positions.positions));
+        info->tables_references = NULL;
+        if (atomic_fetch_sub_explicit(references, 1, memory_order_acq_rel) == 1)
+            free_tables(&old);
+    }
+    info->tables_shared = false;
+}
+
+void player_release_tables(player_t *info)
+{
+    if (!info->tables_shared
+        || atomic_fetch_sub_explicit(info->tables_references, 1, memory_order_acq_rel) == 1)
+        free_tables(info);
+}
@@ -0,0 +1,54 @@
+/** @file
+ * Interfejs klasy współdzielącej tablice graczy między kopiami gry
+ *
+ * Tablice area_parent, area_size, area_refs, free_adjacent, golden_fields
+ * i positions gracza są po skopiowaniu gry wspólne dla obu gier, dopóki któraś z nich
+ * nie zacznie ich zmieniać.
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 22.06.2020
+ */
+
+#ifndef GAMMA_PLAYER_H
+#define GAMMA_PLAYER_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include "gamma.h"
+#include "gamma_t.h"
+
+/** @brief Zaczyna współdzielić tablice gracza z kopią gry
+ * @param[in, out] info   – gracz w kopiowanej grze,
+ * @param[out] copy   – ten sam gracz w kopii gry, będący kopią struktury @p info,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+bool player_share_tables(player_t *info, player_t *copy);
+
+/** @brief Przejmuje na wyłączność tablice gracza
+ * Jeśli inna gra nadal korzysta z tablic, to kopiuje je.
+ * @param[in, out] info   – gracz, którego tablice są współdzielone,
+ */
+
+void player_unshare_tables(player_t *info);
+
+/** @brief Zapewnia, że gra może zmieniać tablice gracza
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] player   – indeks gracza,
+ */
+
+static inline void own_player_tables(gamma_t *g, uint32_t player)
+{
+    if (g->player_info[player].tables_shared)
+        player_unshare_tables(&g->player_info[player]);
+}
+
+/** @brief Oddaje tablice gracza
+ * Zwalnia je, jeśli nie korzysta z nich już żadna inna gra.
+ * @param[in, out] info   – gracz,
+ */
+
+void player_release_tables(player_t *info);
+
+#endif //GAMMA_PLAYER_H
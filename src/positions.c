@@ -0,0 +1,112 @@
+/** @file
+ * Implementacja klasy przechowującej pozycje pól w zbiorach graczy
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 24.06.2020
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "positions.h"
+
+/** @brief Wyznacza miejsce, od którego zaczyna się szukanie pola
+ * @param[in] map   – niepusta tablica pozycji,
+ * @param[in] key   – klucz pola, czyli jego indeks powiększony o 1,
+ * @return Indeks miejsca w tablicy.
+ */
+
+static uint64_t home_slot(const position_map_t *map, uint64_t key)
+{
+    uint64_t hash = key * UINT64_C(0x9E3779B97F4A7C15);
+    return (hash ^ (hash >> 32)) & (map->capacity - 1);
+}
+
+/** @brief Szuka miejsca pola w tablicy
+ * @param[in] map   – niepusta tablica pozycji,
+ * @param[in] key   – klucz pola,
+ * @return Indeks miejsca z kluczem @p key albo pierwszego wolnego miejsca za nim.
+ */
+
+static uint64_t find_slot(const position_map_t *map, uint64_t key)
+{
+    uint64_t slot = home_slot(map, key);
+    while (map->keys[slot] != 0 && map->keys[slot] != key)
+        slot = (slot + 1) & (map->capacity - 1);
+    return slot;
+}
+
+/** @brief Przenosi pola do dwukrotnie większej tablicy
+ * @param[in, out] map   – tablica pozycji,
+ */
+
+static void grow(position_map_t *map)
+{
+    position_map_t old = *map;
+    map->capacity = old.capacity == 0 ? 8 : 2 * old.capacity;
+    map->keys = calloc(map->capacity, sizeof *(map->keys));
+    checkNull(map->keys);
+    map->positions = malloc(map->capacity * sizeof *(map->positions));
+    checkNull(map->positions);
+    for (uint64_t i = 0; i < old.capacity; i++)
+        if (old.keys[i] != 0)
+        {
+            uint64_t slot = find_slot(map, old.keys[i]);
+            map->keys[slot] = old.keys[i];
+            map->positions[slot] = old.positions[i];
+        }
+    free(old.keys);
+    free(old.positions);
+}
+
+bool position_find(const position_map_t *map, uint64_t index, uint32_t *position)
+{
+    if (map->count == 0)
+        return false;
+
+    uint64_t slot = find_slot(map, index + 1);
+    if (map->keys[slot] == 0)
+        return false;
+    *position = map->positions[slot];
+    return true;
+}
+
+uint32_t position_get(const position_map_t *map, uint64_t index)
+{
+    return map->positions[find_slot(map, index + 1)];
+}
+
+void position_set(position_map_t *map, uint64_t index, uint32_t position)
+{
+    if (4 * (map->count + 1) > 3 * map->capacity)
+        grow(map);
+
+    uint64_t slot = find_slot(map, index + 1);
+    if (map->keys[slot] == 0)
+    {
+        map->keys[slot] = index + 1;
+        (map->count)++;
+    }
+    map->positions[slot] = position;
+}
+
+void position_remove(position_map_t *map, uint64_t index)
+{
+    uint64_t mask = map->capacity - 1;
+    uint64_t hole = find_slot(map, index + 1);
+    // Pole z dalszej części ciągu może zająć zwolnione miejsce, jeśli jego
+    // miejsce początkowe nie leży między zwolnionym miejscem a nim samym.
+    for (uint64_t slot = (hole + 1) & mask; map->keys[slot] != 0; slot = (slot + 1) & mask)
+    {
+        uint64_t home = home_slot(map, map->keys[slot]);
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            map->keys[hole] = map->keys[slot];
+            map->positions[hole] = map->positions[slot];
+            hole = slot;
+        }
+    }
+    map->keys[hole] = 0;
+    (map->count)--;
+}
@@ -0,0 +1,56 @@
+/** @file
+ * Interfejs klasy przechowującej pozycje pól w zbiorach graczy
+ *
+ * Pozycje pól w zbiorach free_adjacent i golden_fields gracza są
+ * przechowywane w tablicy z haszowaniem otwartym, więc zajmują pamięć tylko
+ * dla pól należących do któregoś ze zbiorów, a nie dla każdego pola planszy.
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 24.06.2020
+ */
+
+#ifndef GAMMA_POSITIONS_H
+#define GAMMA_POSITIONS_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include "gamma_t.h"
+
+/** @brief Szuka pozycji pola w tablicy
+ * @param[in] map   – tablica pozycji gracza,
+ * @param[in] index   – indeks pola,
+ * @param[out] position   – pozycja pola, jeśli jest w tablicy,
+ * @return Zwraca true jeśli pole jest w tablicy, false w przeciwnym wypadku.
+ */
+
+bool position_find(const position_map_t *map, uint64_t index, uint32_t *position);
+
+/** @brief Podaje pozycję pola, które jest w tablicy
+ * @param[in] map   – tablica pozycji gracza,
+ * @param[in] index   – indeks pola należącego do zbioru gracza,
+ * @return Zwraca pozycję pola.
+ */
+
+uint32_t position_get(const position_map_t *map, uint64_t index);
+
+/** @brief Zapisuje pozycję pola
+ * Dodaje pole do tablicy albo zmienia jego pozycję. Powiększa dwukrotnie
+ * tablicę, gdy byłaby zajęta w więcej niż trzech czwartych.
+ * @param[in, out] map   – tablica pozycji gracza,
+ * @param[in] index   – indeks pola,
+ * @param[in] position   – pozycja pola,
+ */
+
+void position_set(position_map_t *map, uint64_t index, uint32_t position);
+
+/** @brief Usuwa pole z tablicy
+ * Przesuwa wstecz pola z dalszej części ciągu zajętych miejsc, więc tablica
+ * nie potrzebuje znaczników usuniętych pól.
+ * @param[in, out] map   – tablica pozycji gracza,
+ * @param[in] index   – indeks pola, które jest w tablicy,
+ */
+
+void position_remove(position_map_t *map, uint64_t index);
+
+#endif //GAMMA_POSITIONS_H
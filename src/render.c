@@ -0,0 +1,576 @@
+/** @file
+ * Implementacja klasy tworzącej tekstowy opis planszy
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 31.05.2020
+ */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "render.h"
+#include "board.h"
+
+/** Rozmiar bufora, w którym powstają kolejne fragmenty tekstu */
+#define RENDER_CHUNK 65536
+
+/** Największa długość opisu pola: spacja, dziesięć cyfr i spacja */
+#define MAX_FIELD_LENGTH 12
+
+/**
+  * Liczba pól, od której opis planszy w buforze powstaje w kilku wątkach.
+  * Dotyczy to zarówno zapamiętywanego opisu dużych ciągłych plansz,
+  * jak i opisów rzadkich plansz tworzonych przez @ref gamma_board.
+  */
+#define PARALLEL_RENDER_LIMIT ((uint64_t) 1 << 22)
+
+/**
+  * Największa długość zapamiętywanego opisu planszy w najgorszym przypadku.
+  * Ciągłe plansze mogą mieć do @ref DENSE_BOARD_BYTES bajtów pól, a bloki
+  * są zakładane dopiero przy pierwszym użyciu, więc dla opisu przyjęty jest
+  * osobny, mniejszy próg.
+  */
+#define RENDER_CACHE_LIMIT ((uint64_t) 1 << 30)
+
+/** Największa liczba wątków tworzących opis planszy */
+#define MAX_RENDER_THREADS 8
+
+/** Zapisy wszystkich liczb dwucyfrowych, pozwalające wypisywać po dwie cyfry naraz */
+static const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+/** @brief Przekazuje gotowy fragment tekstu do miejsca docelowego
+ * @param[in, out] sink   – miejsce, do którego trafia tekst,
+ * @param[in] chunk   – fragment tekstu,
+ * @param[in] length   – długość fragmentu,
+ */
+
+static void sink_write(render_sink_t *sink, const char *chunk, size_t length)
+{
+    if (sink->stream != NULL)
+    {
+        if (!sink->failed && fwrite(chunk, 1, length, sink->stream) != length)
+            sink->failed = true;
+    }
+    else if (sink->length < sink->size)
+    {
+        uint64_t space = sink->size - sink->length;
+        memcpy(sink->buffer + sink->length, chunk, length < space ? length : space);
+    }
+    sink->length += length;
+}
+
+/** @brief Zapisuje opis pola w formacie dla co najmniej dziesięciu graczy
+ * Numer gracza jest otoczony spacjami, wolne pole jest opisane jako " . ".
+ * @param[out] out   – miejsce na co najmniej @ref MAX_FIELD_LENGTH znaków,
+ * @param[in] owner   – właściciel pola,
+ * @return Liczba zapisanych znaków.
+ */
+
+static size_t format_wide_field(char *out, uint32_t owner)
+{
+    if (owner == 0)
+    {
+        memcpy(out, " . ", 3);
+        return 3;
+    }
+
+    char digits[10];
+    char *begin = digits + sizeof digits;
+    while (owner >= 100)
+    {
+        begin -= 2;
+        memcpy(begin, &digit_pairs[2 * (owner % 100)], 2);
+        owner /= 100;
+    }
+    if (owner >= 10)
+    {
+        begin -= 2;
+        memcpy(begin, &digit_pairs[2 * owner], 2);
+    }
+    else
+        *(--begin) = (char) ('0' + owner);
+
+    size_t length = digits + sizeof digits - begin;
+    out[0] = ' ';
+    memcpy(out + 1, begin, length);
+    out[length + 1] = ' ';
+    return length + 2;
+}
+
+/**
+  * Bufor, w którym powstają kolejne fragmenty tekstu.
+  */
+
+typedef struct render_buffer
+{
+    char chunk[RENDER_CHUNK]; ///< bieżący fragment tekstu
+    size_t used; ///< długość bieżącego fragmentu
+    render_sink_t *sink; ///< miejsce, do którego trafiają gotowe fragmenty
+} render_buffer_t;
+
+/** @brief Dopisuje opis pola do bieżącego fragmentu tekstu
+ * Przekazuje fragment dalej, jeśli mógłby się w nim nie zmieścić opis pola.
+ * @param[in, out] out   – bufor z bieżącym fragmentem,
+ * @param[in] owner   – właściciel pola,
+ * @param[in] wide   – flaga mówiąca czy graczy jest co najmniej dziesięciu,
+ */
+
+static inline void put_field(render_buffer_t *out, uint32_t owner, bool wide)
+{
+    if (out->used > RENDER_CHUNK - MAX_FIELD_LENGTH)
+    {
+        sink_write(out->sink, out->chunk, out->used);
+        out->used = 0;
+    }
+    if (wide)
+        out->used += format_wide_field(out->chunk + out->used, owner);
+    else
+        out->chunk[(out->used)++] = owner == 0 ? '.' : (char) ('0' + owner);
+}
+
+/** @brief Tworzy tekstowy opis wierszy planszy w bieżącym wątku
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] first_row   – numer pierwszego wiersza,
+ * @param[in] rows   – liczba wierszy,
+ * @param[in, out] sink   – miejsce, do którego trafia tekst,
+ */
+
+static void render_rows_sequential(gamma_t *g, uint32_t first_row, uint32_t rows, render_sink_t *sink)
+{
+    render_buffer_t out;
+    out.used = 0;
+    out.sink = sink;
+    bool wide = g->players >= 10;
+
+    for (uint32_t i = first_row; i - first_row < rows; i++)
+    {
+        uint32_t y = g->max_height - 1 - i;
+        // Wiersz jest przeglądany odcinkami leżącymi w jednej tablicy właścicieli:
+        // częścią wiersza w bloku ciągłej planszy albo wierszem fragmentu rzadkiej planszy.
+        for (uint32_t x = 0; x < g->max_width;)
+        {
+            const void *owners;
+            uint64_t index = field_index(g, x, y);
+            uint64_t end = g->max_width;
+            if (g->blocks != NULL)
+            {
+                owners = dense_block(g, index)->owners;
+                if (x + BLOCK_FIELDS - (index & (BLOCK_FIELDS - 1)) < end)
+                    end = x + BLOCK_FIELDS - (index & (BLOCK_FIELDS - 1));
+                index &= BLOCK_FIELDS - 1;
+            }
+            else
+            {
+                tile_t *tile = sparse_tile(g, x, y);
+                owners = tile != NULL ? tile->owners : NULL;
+                index = tile_offset(x, y);
+                if (((uint64_t) (x >> TILE_SHIFT) + 1) * TILE_SIDE < end)
+                    end = ((uint64_t) (x >> TILE_SHIFT) + 1) * TILE_SIDE;
+            }
+
+            if (owners == NULL)
+                for (; x < end; x++)
+                    put_field(&out, 0, wide);
+            else
+                for (; x < end; x++, index++)
+                    put_field(&out, load_owner(g, owners, index), wide);
+        }
+
+        if (out.used == RENDER_CHUNK)
+        {
+            sink_write(sink, out.chunk, out.used);
+            out.used = 0;
+        }
+        out.chunk[(out.used)++] = '\n';
+    }
+    sink_write(sink, out.chunk, out.used);
+}
+
+/** @brief Oblicza długość tekstowego opisu wierszy planszy
+ * Dla mniej niż dziesięciu graczy każde pole zajmuje jeden znak. W przeciwnym
+ * wypadku wolne pole zajmuje trzy znaki, a zajęte dwa znaki więcej niż numer gracza.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] first_row   – numer pierwszego wiersza,
+ * @param[in] rows   – liczba wierszy,
+ * @return Długość opisu wierszy.
+ */
+
+static uint64_t rows_length(gamma_t *g, uint32_t first_row, uint32_t rows)
+{
+    if (g->players < 10)
+        return (uint64_t) rows * ((uint64_t) g->max_width + 1);
+
+    uint64_t length = (uint64_t) rows * (3 * (uint64_t) g->max_width + 1);
+    for (uint32_t i = first_row; i - first_row < rows; i++)
+    {
+        uint32_t y = g->max_height - 1 - i;
+        for (uint32_t x = 0; x < g->max_width;)
+        {
+            const void *owners;
+            uint64_t index = field_index(g, x, y);
+            uint64_t end = g->max_width;
+            if (g->blocks != NULL)
+            {
+                owners = dense_block(g, index)->owners;
+                if (x + BLOCK_FIELDS - (index & (BLOCK_FIELDS - 1)) < end)
+                    end = x + BLOCK_FIELDS - (index & (BLOCK_FIELDS - 1));
+                index &= BLOCK_FIELDS - 1;
+            }
+            else
+            {
+                tile_t *tile = sparse_tile(g, x, y);
+                owners = tile != NULL ? tile->owners : NULL;
+                index = tile_offset(x, y);
+                if (((uint64_t) (x >> TILE_SHIFT) + 1) * TILE_SIDE < end)
+                    end = ((uint64_t) (x >> TILE_SHIFT) + 1) * TILE_SIDE;
+            }
+
+            if (owners == NULL)
+                x = end;
+            else
+                for (; x < end; x++, index++)
+                {
+                    uint32_t owner = load_owner(g, owners, index);
+                    if (owner >= 10)
+                        length += log_10(owner) - 1;
+                }
+        }
+    }
+    return length;
+}
+
+uint64_t render_length(gamma_t *g)
+{
+    if (g->players < 10)
+        return (uint64_t) g->max_height * ((uint64_t) g->max_width + 1);
+
+    uint64_t length = (uint64_t) g->max_height * (3 * (uint64_t) g->max_width + 1);
+    uint32_t digits = 2;
+    uint64_t next_power = 100;
+    for (uint32_t player = 10; player <= g->players; player++)
+    {
+        if (player == next_power)
+        {
+            digits++;
+            next_power *= 10;
+        }
+        length += g->player_info[player].busy_fields * (digits - 1);
+    }
+    return length;
+}
+
+/**
+  * Zadanie wątku tworzącego opis ciągłego bloku wierszy.
+  */
+
+typedef struct render_job
+{
+    gamma_t *g; ///< struktura przechowująca stan gry
+    uint32_t first_row; ///< numer pierwszego wiersza bloku
+    uint32_t rows; ///< liczba wierszy bloku
+    uint64_t length; ///< długość opisu bloku
+    render_sink_t sink; ///< część bufora, do której trafia opis bloku
+} render_job_t;
+
+/** @brief Oblicza długość opisu bloku wierszy w osobnym wątku
+ * @param[in, out] arg   – wskaźnik na zadanie wątku,
+ * @return NULL.
+ */
+
+static void *measure_job(void *arg)
+{
+    render_job_t *job = arg;
+    job->length = rows_length(job->g, job->first_row, job->rows);
+    return NULL;
+}
+
+/** @brief Tworzy opis bloku wierszy w osobnym wątku
+ * @param[in, out] arg   – wskaźnik na zadanie wątku,
+ * @return NULL.
+ */
+
+static void *render_job(void *arg)
+{
+    render_job_t *job = arg;
+    render_rows_sequential(job->g, job->first_row, job->rows, &job->sink);
+    return NULL;
+}
+
+/** @brief Wykonuje funkcję dla każdego zadania, każde w osobnym wątku
+ * Zadania, dla których nie udało się utworzyć wątku, wykonuje w bieżącym wątku.
+ * @param[in] function   – funkcja wątku,
+ * @param[in, out] jobs   – tablica zadań,
+ * @param[in] count   – liczba zadań,
+ */
+
+static void run_jobs(void *(*function)(void *), render_job_t *jobs, uint32_t count)
+{
+    pthread_t threads[MAX_RENDER_THREADS];
+    bool started[MAX_RENDER_THREADS];
+
+    for (uint32_t i = 1; i < count; i++)
+        started[i] = pthread_create(&threads[i], NULL, function, &jobs[i]) == 0;
+    function(&jobs[0]);
+    for (uint32_t i = 1; i < count; i++)
+    {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            function(&jobs[i]);
+    }
+}
+
+/** @brief Tworzy opis wierszy planszy w buforze przy użyciu kilku wątków
+ * Dzieli wiersze na ciągłe bloki. Najpierw każdy wątek liczy długość opisu
+ * swojego bloku, co wyznacza jego miejsce w buforze, a potem zapisuje tam opis.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] first_row   – numer pierwszego wiersza,
+ * @param[in] rows   – liczba wierszy,
+ * @param[in, out] sink   – bufor, do którego trafia tekst,
+ * @return Zwraca true jeśli opis zmieścił się w buforze i został zapisany,
+ * false gdy trzeba go utworzyć sekwencyjnie.
+ */
+
+static bool render_rows_parallel(gamma_t *g, uint32_t first_row, uint32_t rows, render_sink_t *sink)
+{
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t count = MAX_RENDER_THREADS;
+    if (processors > 0 && (uint64_t) processors < count)
+        count = processors;
+    if (rows < count)
+        count = rows;
+    if (count < 2)
+        return false;
+
+    render_job_t jobs[MAX_RENDER_THREADS];
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t begin = (uint64_t) rows * i / count;
+        uint32_t end = (uint64_t) rows * (i + 1) / count;
+        jobs[i].g = g;
+        jobs[i].first_row = first_row + begin;
+        jobs[i].rows = end - begin;
+    }
+    run_jobs(measure_job, jobs, count);
+
+    uint64_t offset = sink->length;
+    for (uint32_t i = 0; i < count; i++)
+        offset += jobs[i].length;
+    if (offset > sink->size)
+        return false;
+
+    offset = sink->length;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        jobs[i].sink = (render_sink_t) {NULL, sink->buffer + offset, jobs[i].length, 0, false};
+        offset += jobs[i].length;
+    }
+    run_jobs(render_job, jobs, count);
+    sink->length = offset;
+    return true;
+}
+
+void render_rows(gamma_t *g, uint32_t first_row, uint32_t rows, render_sink_t *sink)
+{
+    if (sink->stream == NULL && (uint64_t) rows * g->max_width >= PARALLEL_RENDER_LIMIT
+        && render_rows_parallel(g, first_row, rows, sink))
+        return;
+    render_rows_sequential(g, first_row, rows, sink);
+}
+
+/** @brief Tworzy opis wiersza planszy w podanym miejscu
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] row   – numer wiersza opisu,
+ * @param[out] text   – miejsce na opis wiersza,
+ * @param[in] length   – długość opisu wiersza,
+ */
+
+static void render_row_at(gamma_t *g, uint32_t row, char *text, uint64_t length)
+{
+    render_sink_t sink = {NULL, text, length, 0, false};
+    render_rows_sequential(g, row, 1, &sink);
+}
+
+/** @brief Tworzy zapamiętany opis całej planszy od początku
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+static bool build_cache(gamma_t *g)
+{
+    board_cache_t *cache = &g->board_cache;
+    uint64_t words = ((uint64_t) g->max_height + 63) / 64;
+    cache->row_offset = malloc(((uint64_t) g->max_height + 1) * sizeof *(cache->row_offset));
+    cache->dirty = calloc(words, sizeof *(cache->dirty));
+    if (!cache->row_offset || !cache->dirty)
+    {
+        render_cache_delete(g);
+        return false;
+    }
+
+    cache->row_offset[0] = 0;
+    for (uint32_t i = 0; i < g->max_height; i++)
+        cache->row_offset[i + 1] = cache->row_offset[i] + rows_length(g, i, 1);
+
+    uint64_t length = cache->row_offset[g->max_height];
+    cache->text = malloc(length + 1);
+    if (!cache->text)
+    {
+        render_cache_delete(g);
+        return false;
+    }
+    render_sink_t sink = {NULL, cache->text, length, 0, false};
+    render_rows(g, 0, g->max_height, &sink);
+    cache->text[length] = '\0';
+    cache->any_dirty = false;
+    return true;
+}
+
+/** @brief Sprawdza czy wiersz opisu jest oznaczony jako zmieniony
+ * @param[in] cache   – zapamiętany opis planszy,
+ * @param[in] row   – numer wiersza opisu,
+ * @return Zwraca true jeśli wiersz jest oznaczony, false w przeciwnym wypadku.
+ */
+
+static bool is_dirty(const board_cache_t *cache, uint32_t row)
+{
+    return (cache->dirty[row / 64] >> (row % 64)) & 1;
+}
+
+/** @brief Tworzy nowy zapamiętany opis, gdy zmieniła się długość któregoś wiersza
+ * Kopiuje opisy niezmienionych wierszy ze starego opisu, a opisy
+ * zmienionych wierszy tworzy na nowo.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+static bool relayout_cache(gamma_t *g)
+{
+    board_cache_t *cache = &g->board_cache;
+    uint64_t *row_offset = malloc(((uint64_t) g->max_height + 1) * sizeof *row_offset);
+    if (!row_offset)
+        return false;
+
+    row_offset[0] = 0;
+    for (uint32_t i = 0; i < g->max_height; i++)
+    {
+        uint64_t length = is_dirty(cache, i) ? rows_length(g, i, 1)
+                                             : cache->row_offset[i + 1] - cache->row_offset[i];
+        row_offset[i + 1] = row_offset[i] + length;
+    }
+
+    char *text = malloc(row_offset[g->max_height] + 1);
+    if (!text)
+    {
+        free(row_offset);
+        return false;
+    }
+    for (uint32_t i = 0; i < g->max_height; i++)
+    {
+        if (is_dirty(cache, i))
+            render_row_at(g, i, text + row_offset[i], row_offset[i + 1] - row_offset[i]);
+        else
+            memcpy(text + row_offset[i], cache->text + cache->row_offset[i],
+                   row_offset[i + 1] - row_offset[i]);
+    }
+    text[row_offset[g->max_height]] = '\0';
+
+    free(cache->text);
+    free(cache->row_offset);
+    cache->text = text;
+    cache->row_offset = row_offset;
+    return true;
+}
+
+/** @brief Sprawdza czy opis planszy może być zapamiętany
+ * Opis jest zapamiętywany dla ciągłych plansz, których opis w najgorszym
+ * przypadku, gdy wszystkie pola zajmuje gracz o najdłuższym numerze,
+ * nie przekracza @ref RENDER_CACHE_LIMIT znaków.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @return Zwraca true jeśli opis może być zapamiętany, false w przeciwnym wypadku.
+ */
+
+static bool cache_allowed(const gamma_t *g)
+{
+    uint64_t width_of_field = g->players < 10 ? 1 : log_10(g->players) + 2;
+    uint64_t row_length = (uint64_t) g->max_width * width_of_field + 1;
+    return g->blocks != NULL && row_length <= RENDER_CACHE_LIMIT / g->max_height;
+}
+
+bool render_cache_refresh(gamma_t *g)
+{
+    board_cache_t *cache = &g->board_cache;
+    if (!cache_allowed(g))
+        return false;
+    if (cache->text == NULL)
+        return build_cache(g);
+    if (!cache->any_dirty)
+        return true;
+
+    uint64_t words = ((uint64_t) g->max_height + 63) / 64;
+    bool resized = false;
+    for (uint64_t w = 0; w < words && !resized; w++)
+        for (uint64_t bits = cache->dirty[w]; bits != 0 && !resized; bits &= bits - 1)
+        {
+            uint32_t row = w * 64 + __builtin_ctzll(bits);
+            resized = rows_length(g, row, 1) != cache->row_offset[row + 1] - cache->row_offset[row];
+        }
+
+    // Przy mniej niż dziesięciu graczach wiersze mają stałą długość,
+    // więc opisy zmienionych wierszy zawsze trafiają na swoje stare miejsce.
+    if (resized)
+    {
+        if (!relayout_cache(g))
+            return false;
+    }
+    else
+    {
+        for (uint64_t w = 0; w < words; w++)
+            for (uint64_t bits = cache->dirty[w]; bits != 0; bits &= bits - 1)
+            {
+                uint32_t row = w * 64 + __builtin_ctzll(bits);
+                render_row_at(g, row, cache->text + cache->row_offset[row],
+                              cache->row_offset[row + 1] - cache->row_offset[row]);
+            }
+    }
+
+    memset(cache->dirty, 0, words * sizeof *(cache->dirty));
+    cache->any_dirty = false;
+    return true;
+}
+
+void render_cache_mark(gamma_t *g, uint32_t y)
+{
+    board_cache_t *cache = &g->board_cache;
+    if (cache->text == NULL)
+        return;
+    uint32_t row = g->max_height - 1 - y;
+    cache->dirty[row / 64] |= (uint64_t) 1 << (row % 64);
+    cache->any_dirty = true;
+}
+
+void render_cache_delete(gamma_t *g)
+{
+    board_cache_t *cache = &g->board_cache;
+    free(cache->text);
+    free(cache->row_offset);
+    free(cache->dirty);
+    *cache = (board_cache_t) {NULL, NULL, NULL, false};
+}
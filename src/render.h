@@ -0,0 +1,81 @@
+/** @file
+ * Interfejs klasy tworzącej tekstowy opis planszy
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 31.05.2020
+ */
+
+#ifndef GAMMA_RENDER_H
+#define GAMMA_RENDER_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "gamma.h"
+#include "gamma_t.h"
+
+/**
+  * Struktura opisująca miejsce, do którego trafia tekstowy opis planszy.
+  * Jeśli @p stream nie jest NULLem, tekst jest zapisywany do strumienia,
+  * w przeciwnym wypadku do bufora @p buffer, dopóki się w nim mieści.
+  */
+
+typedef struct render_sink
+{
+    FILE *stream; ///< strumień, do którego zapisywany jest tekst (NULL przy zapisie do bufora)
+    char *buffer; ///< bufor, do którego zapisywany jest tekst
+    uint64_t size; ///< rozmiar bufora
+    uint64_t length; ///< długość dotychczas wytworzonego tekstu, także tej części, która nie zmieściła się w buforze
+    bool failed; ///< flaga informująca czy zapis do strumienia się nie powiódł
+} render_sink_t;
+
+/** @brief Tworzy tekstowy opis wierszy planszy
+ * Wiersze są numerowane tak jak w napisie zwracanym przez @ref gamma_board,
+ * wiersz 0 to górny wiersz planszy. Tekst powstaje fragmentami w buforze
+ * stałego rozmiaru, więc funkcja nie alokuje pamięci. Duże plansze zapisywane
+ * do bufora dzieli na bloki wierszy opisywane równolegle w kilku wątkach.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] first_row   – numer pierwszego wiersza,
+ * @param[in] rows   – liczba wierszy,
+ * @param[in, out] sink   – miejsce, do którego trafia tekst,
+ */
+
+void render_rows(gamma_t *g, uint32_t first_row, uint32_t rows, render_sink_t *sink);
+
+/** @brief Oblicza długość tekstowego opisu całej planszy
+ * Nie przegląda pól planszy: długość zależy tylko od jej wymiarów
+ * i od liczby pól zajętych przez każdego gracza, więc funkcja działa
+ * w czasie proporcjonalnym do liczby graczy.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @return Długość opisu planszy, bez kończącego znaku '\0'.
+ */
+
+uint64_t render_length(gamma_t *g);
+
+/** @brief Aktualizuje zapamiętany opis planszy
+ * Przy pierwszym wywołaniu tworzy opis całej planszy, a przy kolejnych
+ * tworzy na nowo tylko opisy wierszy oznaczonych przez @ref render_cache_mark.
+ * Opis jest zapamiętywany tylko dla ciągłych plansz, których opis nie może
+ * przekroczyć ustalonej długości.
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @return Zwraca true jeśli zapamiętany opis jest aktualny, false jeśli plansza
+ * jest rzadka, jej opis byłby zbyt długi lub nie udało się zaalokować pamięci.
+ */
+
+bool render_cache_refresh(gamma_t *g);
+
+/** @brief Oznacza wiersz planszy jako zmieniony od utworzenia zapamiętanego opisu
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ * @param[in] y   – współrzędna y zmienionego pola,
+ */
+
+void render_cache_mark(gamma_t *g, uint32_t y);
+
+/** @brief Zwalnia zapamiętany opis planszy
+ * @param[in, out] g   – struktura przechowująca stan gry,
+ */
+
+void render_cache_delete(gamma_t *g);
+
+#endif //GAMMA_RENDER_H
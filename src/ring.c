@@ -0,0 +1,94 @@
+/** @file
+ * Implementacja kolejki cyklicznej łączącej dwa wątki
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 20.06.2020
+ */
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ring.h"
+#include "gamma_t.h"
+
+/** Liczba sprawdzeń licznika przed oddaniem procesora innym wątkom */
+#define RING_SPINS 256
+/** Liczba oddań procesora, po której wątek zaczyna zasypiać */
+#define RING_YIELDS 4096
+/** Czas snu wątku czekającego na długo pustą lub pełną kolejkę w nanosekundach */
+#define RING_SLEEP_NS 100000
+
+/** @brief Czeka na zmianę licznika drugiej strony kolejki
+ * Przez chwilę sprawdza licznik w pętli, potem oddaje procesor, a gdy
+ * czekanie się przedłuża (np. na dane z terminala), zasypia na krótko.
+ * @param[in] counter   – licznik drugiej strony,
+ * @param[in] old   – dotychczasowa wartość licznika,
+ * @return Nowa wartość licznika.
+ */
+
+static size_t wait_for_change(atomic_size_t *counter, size_t old)
+{
+    uint32_t attempts = 0;
+    while (true)
+    {
+        size_t value = atomic_load_explicit(counter, memory_order_acquire);
+        if (value != old)
+            return value;
+
+        if (attempts < RING_SPINS)
+        {
+            attempts++;
+        }
+        else if (attempts < RING_SPINS + RING_YIELDS)
+        {
+            attempts++;
+            sched_yield();
+        }
+        else
+        {
+            nanosleep(&(struct timespec) {0, RING_SLEEP_NS}, NULL);
+        }
+    }
+}
+
+void ring_init(ring_t *ring, size_t item_size, size_t capacity)
+{
+    ring->items = malloc(item_size * capacity);
+    checkNull(ring->items);
+    ring->item_size = item_size;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->cached_head = 0;
+    ring->cached_tail = 0;
+}
+
+void ring_push(ring_t *ring, const void *item)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    while (tail - ring->cached_head > ring->mask)
+        ring->cached_head = wait_for_change(&ring->head, ring->cached_head);
+
+    memcpy(ring->items + (tail & ring->mask) * ring->item_size, item, ring->item_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+void ring_pop(ring_t *ring, void *item)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while (head == ring->cached_tail)
+        ring->cached_tail = wait_for_change(&ring->tail, ring->cached_tail);
+
+    memcpy(item, ring->items + (head & ring->mask) * ring->item_size, ring->item_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void ring_free(ring_t *ring)
+{
+    free(ring->items);
+}
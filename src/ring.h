@@ -0,0 +1,68 @@
+/** @file
+ * Interfejs kolejki cyklicznej łączącej dwa wątki
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 20.06.2020
+ */
+
+#ifndef GAMMA_RING_H
+#define GAMMA_RING_H
+#include <stdatomic.h>
+#include <stddef.h>
+
+/** Rozmiar linii pamięci podręcznej, na której granicach leżą liczniki kolejki */
+#define RING_ALIGNMENT 64
+
+/**
+  * Kolejka elementów stałego rozmiaru dla jednego producenta i jednego
+  * konsumenta. Nie używa blokad: producent zmienia tylko licznik @p tail,
+  * a konsument tylko licznik @p head. Każda strona pamięta ostatnio
+  * odczytaną wartość licznika drugiej strony, aby rzadko sięgać do jej
+  * linii pamięci.
+  */
+
+typedef struct ring
+{
+    char *items; ///< tablica elementów
+    size_t item_size; ///< rozmiar elementu w bajtach
+    size_t mask; ///< liczba elementów tablicy pomniejszona o 1
+    _Alignas(RING_ALIGNMENT) atomic_size_t head; ///< liczba pobranych elementów
+    size_t cached_tail; ///< ostatnio odczytana przez konsumenta wartość @p tail
+    _Alignas(RING_ALIGNMENT) atomic_size_t tail; ///< liczba dodanych elementów
+    size_t cached_head; ///< ostatnio odczytana przez producenta wartość @p head
+} ring_t;
+
+/** @brief Tworzy pustą kolejkę
+ * @param[out] ring   – kolejka,
+ * @param[in] item_size   – rozmiar elementu w bajtach,
+ * @param[in] capacity   – liczba elementów, potęga dwójki,
+ */
+
+void ring_init(ring_t *ring, size_t item_size, size_t capacity);
+
+/** @brief Dodaje element na koniec kolejki
+ * Czeka, dopóki w kolejce nie zwolni się miejsce.
+ * Może być wywoływana tylko przez wątek producenta.
+ * @param[in, out] ring   – kolejka,
+ * @param[in] item   – wskaźnik na dodawany element,
+ */
+
+void ring_push(ring_t *ring, const void *item);
+
+/** @brief Pobiera element z początku kolejki
+ * Czeka, dopóki kolejka jest pusta.
+ * Może być wywoływana tylko przez wątek konsumenta.
+ * @param[in, out] ring   – kolejka,
+ * @param[out] item   – miejsce na pobrany element,
+ */
+
+void ring_pop(ring_t *ring, void *item);
+
+/** @brief Zwalnia pamięć kolejki
+ * @param[in, out] ring   – kolejka,
+ */
+
+void ring_free(ring_t *ring);
+
+#endif //GAMMA_RING_H
@@ -0,0 +1,623 @@
+/** @file
+ * Implementacja klasy zapisującej stan gry do pliku i wczytującej go z powrotem
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 23.06.2020
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "snapshot.h"
+#include "board.h"
+
+/** Znacznik na początku pliku ze stanem gry */
+#define SNAPSHOT_MAGIC "GAMMASNP"
+
+/** Wersja formatu pliku, zwiększana przy każdej zmianie układu danych */
+#define SNAPSHOT_VERSION 10
+
+/** Wartość zapisywana w pliku, po której rozpoznawana jest kolejność bajtów */
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/** Wyrównanie sekcji pliku w bajtach */
+#define SNAPSHOT_ALIGNMENT 64
+
+/**
+  * Licznik gier zapisywany w pamięci fragmentów i tablic leżących w pliku.
+  * Żadna gra nie zmniejszy go do jedynki, więc ta pamięć jest zawsze
+  * kopiowana przed zmianą i nigdy nie jest zwalniana przez free.
+  */
+
+#define SNAPSHOT_PINNED (UINT32_MAX / 2)
+
+/**
+  * Nagłówek pliku ze stanem gry
+  */
+
+typedef struct snapshot_header
+{
+    char magic[8]; ///< znacznik @ref SNAPSHOT_MAGIC bez kończącego znaku '\0'
+    uint32_t version; ///< wersja formatu pliku
+    uint32_t byte_order; ///< wartość @ref SNAPSHOT_BYTE_ORDER
+    uint32_t field_size; ///< rozmiar informacji o polu bez właściciela w bajtach (zob. @ref field_bytes)
+    uint32_t owner_bytes; ///< rozmiar numeru właściciela w bajtach
+    uint32_t width; ///< szerokość planszy
+    uint32_t height; ///< wysokość planszy
+    uint32_t players; ///< liczba graczy
+    uint32_t areas; ///< maksymalna liczba obszarów gracza
+    uint64_t free_fields; ///< liczba wolnych pól na planszy
+    uint64_t hash; ///< hasz pozycji
+    atomic_uint tables_references; ///< licznik tablic graczy leżących w pliku
+    uint64_t directory_count; ///< liczba bloków ciągłej planszy lub rozmiar tablicy haszującej rzadkiej planszy
+    uint64_t tiles_count; ///< liczba założonych fragmentów rzadkiej planszy
+    uint64_t players_offset; ///< położenie opisów graczy w pliku
+    uint64_t directory_offset; ///< położenie spisu fragmentów w pliku
+    uint64_t size; ///< rozmiar pliku w bajtach
+} snapshot_header_t;
+
+/**
+  * Opis gracza w pliku ze stanem gry. Tablice leżą w pliku osobno,
+  * wyrównane do @ref SNAPSHOT_ALIGNMENT.
+  */
+
+typedef struct snapshot_player
+{
+    uint64_t free_adjacent_fields; ///< liczba dostępnych pól przy maksymalnej liczbie obszarów
+    uint64_t busy_fields; ///< liczba zajętych pól
+    uint64_t golden_fields_count; ///< liczba pól w zbiorze golden_fields
+    uint64_t golden_witness; ///< pozycja w golden_fields, od której zaczyna się szukanie złotego ruchu
+    uint64_t area_count; ///< liczba zapisanych elementów tablic area_parent, area_size i area_refs
+    uint64_t area_parent_offset; ///< położenie tablicy area_parent w pliku
+    uint64_t area_size_offset; ///< położenie tablicy area_size w pliku
+    uint64_t area_refs_offset; ///< położenie tablicy area_refs w pliku
+    uint64_t free_adjacent_offset; ///< położenie tablicy free_adjacent w pliku
+    uint64_t golden_fields_offset; ///< położenie tablicy golden_fields w pliku
+    uint64_t positions_capacity; ///< rozmiar tablicy positions gracza
+    uint64_t positions_count; ///< liczba pól w tablicy positions gracza
+    uint64_t position_keys_offset; ///< położenie kluczy tablicy positions w pliku
+    uint64_t position_values_offset; ///< położenie pozycji tablicy positions w pliku
+    uint32_t current_areas; ///< liczba obszarów gracza
+    uint32_t free_area_number; ///< początek listy zwolnionych numerów obszarów
+    uint32_t used_area_numbers; ///< największy przydzielony numer obszaru
+    uint32_t used_golden_move; ///< czy gracz wykonał już złoty ruch
+} snapshot_player_t;
+
+/**
+  * Wpis spisu fragmentów planszy
+  */
+
+typedef struct snapshot_tile
+{
+    uint64_t key; ///< numer fragmentu rzadkiej planszy, 0 dla bloku ciągłej planszy
+    uint64_t offset; ///< położenie pamięci fragmentu w pliku (0 dla pustego wpisu)
+} snapshot_tile_t;
+
+/**
+  * Pamięć fragmentu przypisana do miejsca w pliku. Bloki ciągłej planszy,
+  * które jeszcze nie zostały użyte, współdzielą jedną pamięć i trafiają
+  * do pliku raz.
+  */
+
+typedef struct placed_tile
+{
+    const uint32_t *areas; ///< numery obszarów pól fragmentu, początek jego pamięci (NULL gdy wpis jest pusty)
+    uint32_t count; ///< liczba pól fragmentu
+    uint64_t offset; ///< położenie pamięci fragmentu w pliku
+} placed_tile_t;
+
+/**
+  * Strumień zapisu pliku wraz z bieżącym położeniem
+  */
+
+typedef struct writer
+{
+    FILE *stream; ///< strumień pliku
+    uint64_t offset; ///< liczba zapisanych bajtów
+    bool ok; ///< czy wszystkie zapisy się powiodły
+} writer_t;
+
+/** @brief Zaokrągla położenie w pliku w górę do wyrównania sekcji
+ * @param[in] offset   – położenie w pliku,
+ * @return Najmniejsze wyrównane położenie nie mniejsze od @p offset.
+ */
+
+static uint64_t aligned(uint64_t offset)
+{
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+/** @brief Dopisuje dane do pliku
+ * @param[in, out] w   – strumień zapisu,
+ * @param[in] data   – dane,
+ * @param[in] size   – rozmiar danych w bajtach,
+ */
+
+static void put(writer_t *w, const void *data, size_t size)
+{
+    if (size > 0 && fwrite(data, 1, size, w->stream) != size)
+        w->ok = false;
+    w->offset += size;
+}
+
+/** @brief Dopisuje zera do pliku aż do podanego położenia
+ * @param[in, out] w   – strumień zapisu,
+ * @param[in] offset   – położenie, od którego zaczyna się następna sekcja,
+ */
+
+static void pad_to(writer_t *w, uint64_t offset)
+{
+    static const char zeros[SNAPSHOT_ALIGNMENT];
+    while (w->offset < offset)
+        put(w, zeros, offset - w->offset < SNAPSHOT_ALIGNMENT ? offset - w->offset : SNAPSHOT_ALIGNMENT);
+}
+
+/** @brief Zwraca wpis spisu fragmentów planszy gry
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] i   – numer wpisu,
+ * @return Blok ciągłej planszy lub wpis tablicy haszującej rzadkiej planszy.
+ */
+
+static tile_t *directory_tile(gamma_t *g, uint64_t i)
+{
+    return g->blocks != NULL ? &g->blocks[i] : &g->tiles[i];
+}
+
+/** @brief Przypisuje pamięci fragmentów miejsca w pliku
+ * Pamięć współdzielona przez kilka wpisów o tej samej liczbie pól dostaje
+ * jedno miejsce, odnajdywane w tablicy haszującej adresów pól.
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] count   – liczba wpisów spisu fragmentów,
+ * @param[out] offsets   – położenia pamięci fragmentów kolejnych wpisów,
+ * @param[in] offset   – położenie pierwszej pamięci fragmentu,
+ * @return Położenie końca ostatniej pamięci fragmentu lub 0, gdy zabrakło pamięci.
+ */
+
+static uint64_t place_tiles(gamma_t *g, uint64_t count, uint64_t *offsets, uint64_t offset)
+{
+    uint64_t capacity = 1;
+    while (capacity < 2 * count)
+        capacity *= 2;
+    placed_tile_t *placed = calloc(capacity, sizeof *placed);
+    if (!placed)
+        return 0;
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        tile_t *tile = directory_tile(g, i);
+        offsets[i] = 0;
+        if (tile->areas == NULL)
+            continue;
+
+        uint32_t fields = tile_fields(g, tile);
+        uint64_t h = ((uint64_t) (uintptr_t) tile->areas * 0x9E3779B97F4A7C15u + fields) & (capacity - 1);
+        while (placed[h].areas != NULL && (placed[h].areas != tile->areas || placed[h].count != fields))
+            h = (h + 1) & (capacity - 1);
+        if (placed[h].areas == NULL)
+        {
+            offset = aligned(offset);
+            placed[h] = (placed_tile_t) {tile->areas, fields, offset};
+            offset += tile_storage_size(g, fields);
+        }
+        offsets[i] = placed[h].offset;
+    }
+    free(placed);
+    return offset;
+}
+
+/** @brief Zapisuje pamięć fragmentów planszy w kolejności przypisanych im miejsc
+ * @param[in, out] w   – strumień zapisu,
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @param[in] count   – liczba wpisów spisu fragmentów,
+ * @param[in] offsets   – położenia pamięci fragmentów kolejnych wpisów,
+ */
+
+static void write_tiles(writer_t *w, gamma_t *g, uint64_t count, const uint64_t *offsets)
+{
+    tile_storage_t header;
+    memset(&header, 0, sizeof header);
+    atomic_init(&header.references, SNAPSHOT_PINNED);
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        // Współdzielona pamięć ma miejsce przed bieżącym położeniem, jeśli już ją zapisano.
+        if (offsets[i] < w->offset)
+            continue;
+
+        tile_t *tile = directory_tile(g, i);
+        pad_to(w, offsets[i]);
+        put(w, &header, sizeof header);
+        put(w, tile->areas, tile_storage_size(g, tile_fields(g, tile)) - sizeof header);
+    }
+}
+
+/** @brief Zapisuje stan gry do otwartego pliku
+ * @param[in, out] w   – strumień zapisu,
+ * @param[in] g   – struktura przechowująca stan gry,
+ * @return Zwraca true jeśli udało się zaalokować pamięć, false w przeciwnym wypadku.
+ */
+
+static bool write_snapshot(writer_t *w, gamma_t *g)
+{
+    uint64_t players = (uint64_t) g->players + 1;
+    uint64_t count = g->blocks != NULL ? g->blocks_count : g->tiles_capacity;
+    snapshot_player_t *records = calloc(players, sizeof *records);
+    snapshot_tile_t *directory = calloc(count, sizeof *directory);
+    uint64_t *offsets = calloc(count, sizeof *offsets);
+    if (!records || !directory || !offsets)
+    {
+        free(records);
+        free(directory);
+        free(offsets);
+        return false;
+    }
+
+    snapshot_header_t header;
+    memset(&header, 0, sizeof header);
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof header.magic);
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.field_size = field_bytes(0);
+    header.owner_bytes = g->owner_bytes;
+    header.width = g->max_width;
+    header.height = g->max_height;
+    header.players = g->players;
+    header.areas = g->max_areas;
+    header.free_fields = g->free_fields;
+    header.hash = g->hash;
+    atomic_init(&header.tables_references, SNAPSHOT_PINNED);
+    header.directory_count = count;
+    header.tiles_count = g->tiles_count;
+
+    // Najpierw wyznaczamy położenia wszystkich sekcji, żeby zapisać plik po kolei.
+    uint64_t offset = aligned(sizeof header);
+    header.players_offset = offset;
+    offset += players * sizeof *records;
+    for (uint64_t i = 0; i < players; i++)
+    {
+        player_t *info = &g->player_info[i];
+        snapshot_player_t *record = &records[i];
+        record->free_adjacent_fields = info->free_adjacent_fields;
+        record->busy_fields = info->busy_fields;
+        record->golden_fields_count = info->golden_fields_count;
+        record->golden_witness = info->golden_witness;
+        record->area_count = info->area_parent != NULL ? (uint64_t) info->used_area_numbers + 1 : 0;
+        record->current_areas = info->current_areas;
+        record->free_area_number = info->free_area_number;
+        record->used_area_numbers = info->used_area_numbers;
+        record->used_golden_move = info->used_golden_move;
+
+        record->area_parent_offset = offset = aligned(offset);
+        offset += record->area_count * sizeof *(info->area_parent);
+        record->area_size_offset = offset = aligned(offset);
+        offset += record->area_count * sizeof *(info->area_size);
+        record->area_refs_offset = offset = aligned(offset);
+        offset += record->area_count * sizeof *(info->area_refs);
+        record->free_adjacent_offset = offset = aligned(offset);
+        offset += record->free_adjacent_fields * sizeof *(info->free_adjacent);
+        record->golden_fields_offset = offset = aligned(offset);
+        offset += record->golden_fields_count * sizeof *(info->golden_fields);
+        record->positions_capacity = info->positions.capacity;
+        record->positions_count = info->positions.count;
+        record->position_keys_offset = offset = aligned(offset);
+        offset += record->positions_capacity * sizeof *(info->positions.keys);
+        record->position_values_offset = offset = aligned(offset);
+        offset += record->positions_capacity * sizeof *(info->positions.positions);
+    }
+    header.directory_offset = aligned(offset);
+    header.size = place_tiles(g, count, offsets, header.directory_offset + count * sizeof *directory);
+    for (uint64_t i = 0; i < count; i++)
+        directory[i] = (snapshot_tile_t) {g->blocks != NULL ? 0 : g->tiles[i].key, offsets[i]};
+
+    bool placed = header.size != 0;
+    if (placed)
+    {
+        put(w, &header, sizeof header);
+        pad_to(w, header.players_offset);
+        put(w, records, players * sizeof *records);
+        for (uint64_t i = 0; i < players; i++)
+        {
+            player_t *info = &g->player_info[i];
+            pad_to(w, records[i].area_parent_offset);
+            put(w, info->area_parent, records[i].area_count * sizeof *(info->area_parent));
+            pad_to(w, records[i].area_size_offset);
+            put(w, info->area_size, records[i].area_count * sizeof *(info->area_size));
+            pad_to(w, records[i].area_refs_offset);
+            put(w, info->area_refs, records[i].area_count * sizeof *(info->area_refs));
+            pad_to(w, records[i].free_adjacent_offset);
+            put(w, info->free_adjacent, records[i].free_adjacent_fields * sizeof *(info->free_adjacent));
+            pad_to(w, records[i].golden_fields_offset);
+            put(w, info->golden_fields, records[i].golden_fields_count * sizeof *(info->golden_fields));
+            pad_to(w, records[i].position_keys_offset);
+            put(w, info->positions.keys, records[i].positions_capacity * sizeof *(info->positions.keys));
+            pad_to(w, records[i].position_values_offset);
+            put(w, info->positions.positions,
+                records[i].positions_capacity * sizeof *(info->positions.positions));
+        }
+        pad_to(w, header.directory_offset);
+        put(w, directory, count * sizeof *directory);
+        write_tiles(w, g, count, offsets);
+    }
+
+    free(records);
+    free(directory);
+    free(offsets);
+    return placed;
+}
+
+bool gamma_save(gamma_t *g, const char *path)
+{
+    if (g == NULL || path == NULL)
+        return false;
+
+    // Plik jest zapisywany obok i podmieniany w całości, bo gry wczytane
+    // z poprzedniej wersji pliku wciąż mogą korzystać z jego pamięci.
+    size_t length = strlen(path);
+    char *temporary = malloc(length + sizeof ".XXXXXX");
+    if (!temporary)
+        return false;
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".XXXXXX", sizeof ".XXXXXX");
+
+    int fd = mkstemp(temporary);
+    FILE *stream = fd < 0 ? NULL : fdopen(fd, "wb");
+    if (!stream)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(temporary);
+        }
+        free(temporary);
+        return false;
+    }
+
+    writer_t w = {stream, 0, true};
+    bool written = write_snapshot(&w, g) && w.ok;
+    written = fclose(stream) == 0 && written && rename(temporary, path) == 0;
+    if (!written)
+        unlink(temporary);
+    free(temporary);
+    return written;
+}
+
+/** @brief Sprawdza czy obszar o podanym położeniu i rozmiarze leży w pliku
+ * @param[in] size   – rozmiar pliku,
+ * @param[in] offset   – położenie obszaru,
+ * @param[in] count   – liczba elementów obszaru,
+ * @param[in] element   – rozmiar elementu w bajtach,
+ * @return Zwraca true jeśli obszar jest wyrównany do 8 bajtów i mieści się w pliku.
+ */
+
+static bool in_file(uint64_t size, uint64_t offset, uint64_t count, uint64_t element)
+{
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / element;
+}
+
+/** @brief Sprawdza nagłówek pliku ze stanem gry
+ * @param[in] header   – nagłówek,
+ * @param[in] size   – rozmiar pliku,
+ * @return Zwraca true jeśli plik pochodzi z tej samej wersji programu
+ * i jego sekcje mieszczą się w pliku, false w przeciwnym wypadku.
+ */
+
+static bool header_valid(const snapshot_header_t *header, uint64_t size)
+{
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof header->magic) != 0
+        || header->version != SNAPSHOT_VERSION || header->byte_order != SNAPSHOT_BYTE_ORDER
+        || header->field_size != field_bytes(0) || header->size != size)
+        return false;
+
+    if (header->width == 0 || header->height == 0 || header->players == 0
+        || header->players == UINT32_MAX || header->areas == 0)
+        return false;
+
+    // Ciągła plansza ma stałą liczbę bloków, a tablica haszująca rzadkiej planszy rozmiar będący potęgą dwójki.
+    uint32_t owner_bytes = header->players <= UINT8_MAX ? 1 : header->players <= UINT16_MAX ? 2 : 4;
+    uint64_t fields = (uint64_t) header->width * header->height;
+    uint64_t count = header->directory_count;
+    bool directory_valid = board_dense(fields, owner_bytes)
+                           ? count == (fields + BLOCK_FIELDS - 1) >> BLOCK_SHIFT
+                           : count != 0 && (count & (count - 1)) == 0 && header->tiles_count <= count;
+    return header->owner_bytes == owner_bytes && directory_valid
+           && in_file(size, header->players_offset, (uint64_t) header->players + 1, sizeof(snapshot_player_t))
+           && in_file(size, header->directory_offset, count, sizeof(snapshot_tile_t));
+}
+
+/** @brief Odtwarza gracza z opisu w pliku
+ * Tablice gracza wskazują na pamięć pliku i są kopiowane przy pierwszej zmianie.
+ * @param[in] g   – wczytywana gra,
+ * @param[in] header   – nagłówek pliku,
+ * @param[in] record   – opis gracza,
+ * @param[out] info   – gracz,
+ * @return Zwraca true jeśli tablice gracza mieszczą się w pliku, false w przeciwnym wypadku.
+ */
+
+static bool restore_player(gamma_t *g, snapshot_header_t *header, const snapshot_player_t *record, player_t *info)
+{
+    char *base = g->snapshot->address;
+    uint64_t size = g->snapshot->size;
+    if (!in_file(size, record->area_parent_offset, record->area_count, sizeof *(info->area_parent))
+        || !in_file(size, record->area_size_offset, record->area_count, sizeof *(info->area_size))
+        || !in_file(size, record->area_refs_offset, record->area_count, sizeof *(info->area_refs))
+        || !in_file(size, record->free_adjacent_offset, record->free_adjacent_fields, sizeof *(info->free_adjacent))
+        || !in_file(size, record->golden_fields_offset, record->golden_fields_count, sizeof *(info->golden_fields))
+        || !in_file(size, record->position_keys_offset, record->positions_capacity, sizeof *(info->positions.keys))
+        || !in_file(size, record->position_values_offset, record->positions_capacity,
+                    sizeof *(info->positions.positions))
+        || (record->positions_capacity & (record->positions_capacity - 1)) != 0
+        || 4 * record->positions_count > 3 * record->positions_capacity
+        || (record->area_count != 0 && record->area_count != (uint64_t) record->used_area_numbers + 1))
+        return false;
+
+    info->free_adjacent_fields = record->free_adjacent_fields;
+    info->used_golden_move = record->used_golden_move;
+    info->current_areas = record->current_areas;
+    info->area_parent = record->area_count != 0 ? (uint32_t *) (base + record->area_parent_offset) : NULL;
+    info->area_size = record->area_count != 0 ? (uint64_t *) (base + record->area_size_offset) : NULL;
+    info->area_refs = record->area_count != 0 ? (uint64_t *) (base + record->area_refs_offset) : NULL;
+    info->area_capacity = record->area_count;
+    info->free_area_number = record->free_area_number;
+    info->used_area_numbers = record->used_area_numbers;
+    info->busy_fields = record->busy_fields;
+    info->free_adjacent = record->free_adjacent_fields != 0
+                          ? (uint64_t *) (base + record->free_adjacent_offset) : NULL;
+    info->free_adjacent_capacity = record->free_adjacent_fields;
+    info->golden_fields = record->golden_fields_count != 0
+                          ? (uint64_t *) (base + record->golden_fields_offset) : NULL;
+    info->golden_fields_count = record->golden_fields_count;
+    info->golden_fields_capacity = record->golden_fields_count;
+    info->golden_witness = record->golden_witness;
+    info->positions.capacity = record->positions_capacity;
+    info->positions.count = record->positions_count;
+    info->positions.keys = record->positions_capacity != 0
+                           ? (uint64_t *) (base + record->position_keys_offset) : NULL;
+    info->positions.positions = record->positions_capacity != 0
+                                ? (uint32_t *) (base + record->position_values_offset) : NULL;
+    info->tables_shared = info->area_parent != NULL || info->free_adjacent != NULL || info->golden_fields != NULL
+                          || info->positions.keys != NULL;
+    info->tables_references = info->tables_shared ? &header->tables_references : NULL;
+    return true;
+}
+
+/** @brief Odtwarza planszę ze spisu fragmentów w pliku
+ * Fragmenty wskazują na pamięć pliku i są kopiowane przy pierwszym użyciu ich pól.
+ * @param[in, out] g   – wczytywana gra,
+ * @param[in] header   – nagłówek pliku,
+ * @return Zwraca true jeśli udało się zaalokować pamięć i fragmenty
+ * mieszczą się w pliku, false w przeciwnym wypadku.
+ */
+
+static bool restore_board(gamma_t *g, const snapshot_header_t *header)
+{
+    char *base = g->snapshot->address;
+    const snapshot_tile_t *directory = (const snapshot_tile_t *) (base + header->directory_offset);
+    uint64_t count = header->directory_count;
+    tile_t *tiles = calloc(count, sizeof *tiles);
+    if (!tiles)
+        return false;
+
+    bool dense = board_dense((uint64_t) g->max_width * g->max_height, header->owner_bytes);
+    if (dense)
+    {
+        g->blocks = tiles;
+        g->blocks_count = count;
+    }
+    else
+    {
+        g->tiles = tiles;
+        g->tiles_capacity = count;
+        g->tiles_count = header->tiles_count;
+    }
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (directory[i].offset == 0 && !dense)
+            continue;
+
+        uint32_t fields = tile_fields(g, &tiles[i]);
+        if (directory[i].offset == 0 || !in_file(g->snapshot->size, directory[i].offset, 1, tile_storage_size(g, fields)))
+            return false;
+        tiles[i].key = directory[i].key;
+        tile_attach(g, &tiles[i], (tile_storage_t *) (base + directory[i].offset), fields);
+        tiles[i].shared = true;
+    }
+    return true;
+}
+
+/** @brief Odtwarza grę z pliku zmapowanego do pamięci
+ * @param[in] address   – początek zmapowanego pliku,
+ * @param[in] size   – rozmiar pliku,
+ * @return Wskaźnik na wczytaną grę lub NULL, gdy plik jest niepoprawny
+ * lub nie udało się zaalokować pamięci.
+ */
+
+static gamma_t *restore(void *address, uint64_t size)
+{
+    snapshot_header_t *header = address;
+    if (!header_valid(header, size))
+        return NULL;
+
+    gamma_t *g = calloc(1, sizeof *g);
+    snapshot_t *snapshot = malloc(sizeof *snapshot);
+    player_t *player_info = calloc((uint64_t) header->players + 1, sizeof *player_info);
+    if (!g || !snapshot || !player_info)
+    {
+        free(g);
+        free(snapshot);
+        free(player_info);
+        return NULL;
+    }
+
+    atomic_init(&snapshot->references, 1);
+    snapshot->address = address;
+    snapshot->size = size;
+    g->snapshot = snapshot;
+    g->player_info = player_info;
+    g->max_width = header->width;
+    g->max_height = header->height;
+    g->max_areas = header->areas;
+    g->players = header->players;
+    g->free_fields = header->free_fields;
+    g->owner_bytes = header->owner_bytes;
+    g->visit_epoch = 0;
+    g->hash = header->hash;
+
+    const snapshot_player_t *records = (const snapshot_player_t *) ((char *) address + header->players_offset);
+    bool ok = true;
+    for (uint64_t i = 0; i < (uint64_t) g->players + 1 && ok; i++)
+        ok = restore_player(g, header, &records[i], &player_info[i]);
+    if (!ok || !restore_board(g, header))
+    {
+        free(g->blocks);
+        free(g->tiles);
+        free(player_info);
+        free(snapshot);
+        free(g);
+        return NULL;
+    }
+    return g;
+}
+
+gamma_t *gamma_load(const char *path)
+{
+    if (path == NULL)
+        return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    // Mapowanie prywatne pozwala grze zmieniać liczniki w pamięci pliku bez zmiany samego pliku.
+    struct stat status;
+    void *address = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && (uint64_t) status.st_size >= sizeof(snapshot_header_t))
+        address = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+        return NULL;
+
+    gamma_t *g = restore(address, status.st_size);
+    if (!g)
+        munmap(address, status.st_size);
+    return g;
+}
+
+void snapshot_release(snapshot_t *snapshot)
+{
+    if (snapshot != NULL && atomic_fetch_sub_explicit(&snapshot->references, 1, memory_order_acq_rel) == 1)
+    {
+        munmap(snapshot->address, snapshot->size);
+        free(snapshot);
+    }
+}
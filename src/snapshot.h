@@ -0,0 +1,27 @@
+/** @file
+ * Interfejs klasy zapisującej stan gry do pliku i wczytującej go z powrotem
+ *
+ * Plik zawiera nagłówek z numerem wersji formatu, opisy graczy, ich tablice,
+ * spis fragmentów planszy i pamięć fragmentów w takim układzie, w jakim
+ * leżą w pamięci gry. Wczytanie pliku mapuje go do pamięci i nie przegląda
+ * pól planszy (zob. @ref gamma_load).
+ *
+ * @author Bartosz Ławny <bl418396@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 23.06.2020
+ */
+
+#ifndef GAMMA_SNAPSHOT_H
+#define GAMMA_SNAPSHOT_H
+
+#include "gamma.h"
+#include "gamma_t.h"
+
+/** @brief Oddaje zmapowany plik ze stanem gry
+ * Usuwa mapowanie, jeśli nie korzysta z niego już żadna inna gra.
+ * @param[in, out] snapshot   – zmapowany plik, może być NULLem,
+ */
+
+void snapshot_release(snapshot_t *snapshot);
+
+#endif //GAMMA_SNAPSHOT_H
@@ -0,0 +1,27 @@
+# Uruchamia program na pliku TEST.in i porównuje jego wyjście i wyjście
+# błędów z plikami TEST.out i TEST.err. Pliki porównywane są bajt po bajcie,
+# więc skrypt obsługuje także binarny tryb wsadowy.
+#
+# Parametry: PROGRAM, TEST, OUTPUT (przedrostek plików z wynikami) oraz
+# opcjonalnie PIPELINE, wartość zmiennej środowiskowej GAMMA_PIPELINE.
+
+if (DEFINED PIPELINE)
+    set(ENV{GAMMA_PIPELINE} ${PIPELINE})
+endif ()
+
+execute_process(COMMAND ${PROGRAM}
+    INPUT_FILE ${TEST}.in
+    OUTPUT_FILE ${OUTPUT}.out
+    ERROR_FILE ${OUTPUT}.err
+    RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${PROGRAM} zakończył działanie z kodem ${result}")
+endif ()
+
+foreach (stream out err)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${TEST}.${stream} ${OUTPUT}.${stream}
+        RESULT_VARIABLE different)
+    if (different)
+        message(FATAL_ERROR "${OUTPUT}.${stream} różni się od ${TEST}.${stream}")
+    endif ()
+endforeach ()